@@ -1,13 +1,34 @@
 //------------------------------------------------------------------------------
 // Author: Jan Riechers <jan@dwrox.net>
 //------------------------------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 #include <time.h>
 #include <math.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+// NOTE: Structs of libraries and the kernel keep their own layout, see -fpack-struct=2 in the Makefile
+#pragma pack(push, 8)
+#include <pthread.h>
+#include <regex.h>
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#endif
+#pragma pack(pop)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "wickedbinary.h"
 
 //------------------------------------------------------------------------------
 
@@ -17,29 +38,92 @@
 #define DOWRITEOUT true
 #define LINESTOPROCESS 0
 #define STRAIGHTWRITEOUT false
+#define REDIRECTTABLE false
+#define SPLITPUNCTUATION false
+#define BINARYWRITEOUT false
+#define ASYNCWRITEOUT true
+#define COMPRESSWRITEOUT COMPRESSNONE
+#define SHARDCOUNT 0
+#define SHARDPAGES 0
+#define SHARDBYTES 0
+#define PAGEINDEX false
+#define MEMORYBUDGET 0
+#define VOCABULARY false
+#define WORDIDS false
+#define INVERTEDINDEX false
+#define LINKGRAPH false
+#define LINKSONLY false
+#define NORMALIZETARGETS false
+#define TARGETIDS false
+#define SHARETAGS false
+#define FORMATSPANS false
+#define SECTIONINDEX false
+#define TEMPLATEPARAMETERS false
+#define PAGEMETADATA false
+#define REVISIONDELTAS false
+#define INCREMENTAL false
 //#define LINESTOPROCESS 1085
 //#define LINESTOPROCESS 110
 //#define LINESTOPROCESS 128
 //#define LINESTOPROCESS 861531
 //#define LINESTOPROCESS 0
 
+// Compression of the text write out, COMPRESSGZIP needs -lz
+#define COMPRESSNONE 0
+#define COMPRESSGZIP 1
+#define COMPRESSLEVEL 3
+
+#if COMPRESSWRITEOUT == COMPRESSGZIP
+#pragma pack(push, 8)
+#include <zlib.h>
+#pragma pack(pop)
+#define OUTPUTSUFFIX ".gz"
+#else
+#define OUTPUTSUFFIX ""
+#endif
+
 //#define SOURCEFILE "data/enwik8_small"
 #define SOURCEFILE "data/enwik8"
 //#define SOURCEFILE "data/enwiki-20160720-pages-meta-current1.xml-p000000010p000030303"
 
-#if STRAIGHTWRITEOUT
-#define DICTIONARYFILE "words.txt"
-#define WIKITAGSFILE "wikitags.txt"
-#define XMLTAGFILE "xmltags.txt"
-#define XMLDATAFILE "xmldata.txt"
-#define ENTITIESFILE "entities.txt"
+#if BINARYWRITEOUT
+#define DICTIONARYFILE "words.wkd"
+#define WIKITAGSFILE "wikitags.wkd"
+#define XMLTAGFILE "xmltags.wkd"
+#define XMLDATAFILE "xmldata.wkd"
+#define ENTITIESFILE "entities.wkd"
+#define REDIRECTSFILE "redirects.wkd"
+#elif STRAIGHTWRITEOUT
+#define DICTIONARYFILE "words.txt" OUTPUTSUFFIX
+#define WIKITAGSFILE "wikitags.txt" OUTPUTSUFFIX
+#define XMLTAGFILE "xmltags.txt" OUTPUTSUFFIX
+#define XMLDATAFILE "xmldata.txt" OUTPUTSUFFIX
+#define ENTITIESFILE "entities.txt" OUTPUTSUFFIX
+#define REDIRECTSFILE "redirects.txt" OUTPUTSUFFIX
 #else
-#define DICTIONARYFILE "words_sort.txt"
-#define WIKITAGSFILE "wikitags_sort.txt"
-#define XMLTAGFILE "xmltags_sort.txt"
-#define XMLDATAFILE "xmldata_sort.txt"
-#define ENTITIESFILE "entities_sort.txt"
+#define DICTIONARYFILE "words_sort.txt" OUTPUTSUFFIX
+#define WIKITAGSFILE "wikitags_sort.txt" OUTPUTSUFFIX
+#define XMLTAGFILE "xmltags_sort.txt" OUTPUTSUFFIX
+#define XMLDATAFILE "xmldata_sort.txt" OUTPUTSUFFIX
+#define ENTITIESFILE "entities_sort.txt" OUTPUTSUFFIX
+#define REDIRECTSFILE "redirects_sort.txt" OUTPUTSUFFIX
 #endif
+#define MANIFESTFILE "manifest.txt"
+#define PAGEINDEXFILE "pages.wki"
+#define RUNDIRECTORY "."
+#define VOCABULARYFILE "vocabulary.wkv"
+#define RANKEDDICTIONARYFILE "dictionary.txt"
+#define INVERTEDINDEXFILE "postings.wkp"
+#define LINKGRAPHFILE "links.wkg"
+#define UNRESOLVEDLINKSFILE "unresolved.txt"
+#define TARGETSFILE "targets.txt"
+#define FORMATSPANSFILE "formats.txt"
+#define SECTIONINDEXFILE "sections.txt"
+#define PARAMETERSFILE "parameters.txt"
+#define METADATAFILE "metadata.wkm"
+#define REVISIONDELTASFILE "deltas.txt"
+#define REVISIONMANIFESTFILE "revisions.txt"
+#define PREVIOUSDIRECTORY "previous"
 /*
 #define DICTIONARYFILE "data/words.txt"
 #define WIKITAGSFILE "data/wikitags.txt"
@@ -49,15 +133,57 @@
 
 // Buffers
 #define LINEBUFFERBASE 5120
+#define OUTPUTBUFFERSIZE 1048576
+#define OUTPUTBUFFERS 2
+#define ASYNCQUEUESIZE 32
+#define OUTPUTFILES 6
+#define FILENAMELENGTH 256
+#define RUNFILES 5
+#define VOCABULARYTABLESIZE 4096
+#define VOCABULARYBLOCK 16
+#define LINKTABLESIZE 4096
+#define TARGETTABLESIZE 4096
+#define SHAREDTAGTABLESIZE 4096
+#define FORMATSPANTABLESIZE 1024
+#define SECTIONTABLESIZE 1024
+#define PARAMETERTABLESIZE 4096
+#define PAGEMETADATATABLESIZE 1024
+#define REVISIONTOKENSIZE 4096
+#define REVISIONDIFFLIMIT 1024
+#define INCREMENTALTABLESIZE 1024
+#define INCREMENTALLINEBUFFER 4096
+
+// Fields of the text write out written as hex
+#define OUTPUTHEXPOSITION 1
+#define OUTPUTHEXPARENT 2
+#define OUTPUTHEXPRESPACES 4
+#define OUTPUTHEXSPACES 8
 
 // Counts of predefined const datatypes
 #define FORMATS 8
+#define HEADINGFORMAT 3
 #define ENTITIES 211
 #define INDENTS 3
 #define TEMPLATES 11
-#define TAGTYPES 13
+#define TAGTYPES 18
 #define TAGCLOSINGS 3
+#define INLINESPANS 4
 #define MATHTAG 0
+#define TABLETAG 2
+#define LINKTAG 12
+#define REFTAG 13
+#define TABLEROWTAG 14
+#define TABLECELLTAG 15
+#define TABLEHEADERTAG 16
+#define TABLECAPTIONTAG 17
+#define REFSPAN 3
+#define NAMESPACETAGTYPES 9
+#define NAMESPACEKEYS 7
+#define NAMESPACEALIASES 3
+#define NAMESPACETABLESIZE 64
+#define NAMESPACENAMELENGTH 64
+#define INTERWIKIKEY -3
+#define PUNCTUATIONS 16
 
 //------------------------------------------------------------------------------
 
@@ -113,12 +239,52 @@ typedef struct wikiTag {
   bool formatStart;
   bool formatEnd;
   bool hasPipe;
-  char *target;
+  // Id of the target in the target table
+  unsigned int target;
   struct word *pipedWords;
   struct wikiTag *pipedTags;
   struct entity *pipedEntities;
+  // Canonical copy with SHARETAGS, the children above are the ones of the copy then
+  struct sharedTag *shared;
 } wikiTag;
 
+/*
+  NOTE: Canonical copies of the wikitag subtrees with SHARETAGS, open addressing
+        by the hash of the children. The copy owns the children, wikitags with
+        the same children point to them and own none. Positions and lines of
+        the children are the ones of the copy, shifted by the difference of
+        the position and line of the wikitag to the copy.
+*/
+typedef struct sharedTag {
+  unsigned int hash;
+  struct wikiTag tag;
+} sharedTag;
+
+typedef struct sharedTagTable {
+  unsigned int size;
+  unsigned int count;
+  unsigned int useCount;
+  struct sharedTag **entries;
+} sharedTagTable;
+
+#pragma pack()
+typedef struct redirect {
+  unsigned int pageId;
+  unsigned int lineNum;
+  char *title;
+  char *target;
+} redirect;
+
+// Page of the dump, lines and byte offset in the source file
+#pragma pack()
+typedef struct page {
+  unsigned int pageId;
+  unsigned int startLine;
+  unsigned int endLine;
+  unsigned long long startByte;
+  char *title;
+} page;
+
 #pragma pack()
 typedef struct xmlNode {
   unsigned short indent;
@@ -142,8 +308,12 @@ typedef struct xmlNode {
 typedef struct xmlDataCollection {
   unsigned int count;
   unsigned int openNodeCount;
+  unsigned int redirectCount;
+  unsigned int pageCount;
   unsigned int *openNodes;
   struct xmlNode *nodes;
+  struct redirect *redirects;
+  struct page *pages;
 } xmlDataCollection;
 
 typedef struct collectionStatistics {
@@ -162,22 +332,509 @@ typedef struct collectionStatistics {
   unsigned int byteXMLsaved;
   unsigned int byteNewLine;
   unsigned int byteFormatting;
+  unsigned int byteRedirects;
+  unsigned int invalidUTF8;
   unsigned int failedElements;
+  unsigned int spilledNodes;
 } collectionStatistics;
 
 //------------------------------------------------------------------------------
 
+// Wikitag or table which is still open at the end of a line
+#pragma pack()
+typedef struct openWikiTagState {
+  unsigned int startLine;
+  unsigned int startPosition;
+  unsigned int dataLength;
+  unsigned int dataBuffer;
+  unsigned short wikiTagDepth;
+  unsigned short mathDeep;
+  short wikiTagType;
+  short dataFormatType;
+  short ownFormatType;
+  bool isFormatStart;
+  bool hasPipe;
+  unsigned char preSpacesCount;
+  char *data;
+} openWikiTagState;
+
+//------------------------------------------------------------------------------
+
+// Namespace names of the dump and the wikitag types of links using them
+#pragma pack()
+typedef struct namespaceEntry {
+  short key;
+  short tagType;
+  char *name;
+} namespaceEntry;
+
+typedef struct namespaceTable {
+  unsigned int size;
+  unsigned int count;
+  struct namespaceEntry *entries;
+} namespaceTable;
+
+//------------------------------------------------------------------------------
+
+// Distinct words of the dump, open addressing by the FNV-1a hash of the word
+#pragma pack()
+typedef struct vocabularyEntry {
+  unsigned int hash;
+  unsigned int count;
+  unsigned int rank;
+  char *data;
+  // Postings of the inverted index, delta encoded varints of page and position
+  unsigned int pageCount;
+  unsigned int lastPage;
+  unsigned int lastPosition;
+  unsigned int postingsLength;
+  unsigned int postingsSize;
+  unsigned char *postings;
+} vocabularyEntry;
+
+typedef struct vocabularyTable {
+  unsigned int size;
+  unsigned int count;
+  struct vocabularyEntry *entries;
+} vocabularyTable;
+
+/*
+  NOTE: Targets of the "Link" wikitags in dump order, "pages" holds the page
+        count at each link, pages are counted from 1 as for the postings.
+*/
+typedef struct linkTable {
+  unsigned int size;
+  unsigned int count;
+  unsigned int *pages;
+  unsigned int *targets;
+} linkTable;
+
+/*
+  NOTE: Distinct targets of the wikitags, open addressing by the FNV-1a hash.
+        "slots" holds the target id + 1, 0 is a free slot, the ids count the
+        targets in the order they are first seen.
+*/
+typedef struct targetTable {
+  unsigned int size;
+  unsigned int count;
+  unsigned int *slots;
+  unsigned int *hashes;
+  char **data;
+} targetTable;
+
+// NOTE: Record of a page to sort the page index and the link graph by page id or title
+typedef struct pageOrder {
+  const char *title;
+  unsigned int pageId;
+  unsigned int record;
+} pageOrder;
+
+/*
+  NOTE: Formatted runs of the tokens of a data node with FORMATSPANS, from the
+        first to the last token of the run by line and position. The outer
+        format of a token is its data format or else its own format, a nested
+        format is an own format different from the outer one. "tokens" holds
+        the tokens of the node the spans are collected of.
+*/
+typedef struct formatSpan {
+  unsigned int startLine;
+  unsigned int startPosition;
+  unsigned int endLine;
+  unsigned int endPosition;
+  short formatType;
+} formatSpan;
+
+typedef struct formatToken {
+  unsigned int lineNum;
+  unsigned int position;
+  short outerFormatType;
+  short nestedFormatType;
+} formatToken;
+
+typedef struct formatSpanTable {
+  unsigned int size;
+  unsigned int count;
+  unsigned int tokenSize;
+  unsigned int tokenCount;
+  struct formatSpan *spans;
+  struct formatToken *tokens;
+} formatSpanTable;
+
+/*
+  NOTE: Sections of the text of the pages with SECTIONINDEX, numbered as
+        MediaWiki does, 0 for the lead before the first heading and the
+        headings from 1 on. A section holds its subsections, "parent" is the
+        number of the section it belongs to or -1, the lead belongs to none
+        and holds none. The bytes are the ones of the lines in the source file.
+        "headingLines" and "headingBytes" hold the lines starting with '=' of
+        the last node, "nodeStartByte" the byte its first line starts at.
+*/
+typedef struct section {
+  unsigned int pageId;
+  unsigned int number;
+  int parent;
+  unsigned short level;
+  unsigned int firstLine;
+  unsigned int firstPosition;
+  unsigned int lastLine;
+  unsigned int lastPosition;
+  unsigned long long startByte;
+  unsigned long long endByte;
+  char *title;
+} section;
+
+typedef struct sectionToken {
+  unsigned int lineNum;
+  unsigned int position;
+  short formatType;
+  unsigned int spacesCount;
+  const char *data;
+} sectionToken;
+
+typedef struct sectionTable {
+  unsigned int size;
+  unsigned int count;
+  unsigned int tokenSize;
+  unsigned int tokenCount;
+  unsigned int headingSize;
+  unsigned int headingCount;
+  unsigned long long nodeStartByte;
+  unsigned int *headingLines;
+  unsigned long long *headingBytes;
+  struct section *sections;
+  struct sectionToken *tokens;
+} sectionTable;
+
+/*
+  NOTE: Parameters of the templates with TEMPLATEPARAMETERS in dump order.
+        Named parameters are kept by their key, positional ones by their
+        number among the positional ones as MediaWiki names them, "index"
+        counts all parameters of the template from 1. The keys are interned in
+        "keys", "templateName" is the target id of the template. Values keep
+        their text with each run of whitespace as one space.
+*/
+typedef struct templateParameter {
+  unsigned int pageId;
+  unsigned int lineNum;
+  unsigned int position;
+  unsigned int templateName;
+  unsigned int key;
+  unsigned short index;
+  char *value;
+} templateParameter;
+
+typedef struct parameterTable {
+  unsigned int size;
+  unsigned int count;
+  struct targetTable keys;
+  struct templateParameter *parameters;
+} parameterTable;
+
+/*
+  NOTE: Metadata of the pages with PAGEMETADATA by the record number of the
+        page, the last revision of a page wins. "isRevision" and
+        "isContributor" tell which id the next <id> line is.
+*/
+typedef struct pageMetadata {
+  unsigned int revisionId;
+  unsigned int parentId;
+  unsigned int contributorId;
+  short namespaceKey;
+  bool isMinor;
+  bool hasSha1;
+  long long timestamp;
+  unsigned char sha1[WICKEDSHA1SIZE];
+} pageMetadata;
+
+typedef struct metadataTable {
+  unsigned int size;
+  unsigned int count;
+  bool isRevision;
+  bool isContributor;
+  struct pageMetadata *records;
+} metadataTable;
+
+/*
+  NOTE: Token streams of the revisions with REVISIONDELTAS. Each text of a page
+        after the first one is compared to the text before by the hashes of
+        its tokens, the edit script is written to REVISIONDELTASFILE and the
+        tokens of the text are freed. "hashes" holds the stream of the text
+        before, "pageRecord" the page count of its page.
+*/
+typedef struct revisionToken {
+  unsigned int lineNum;
+  unsigned int position;
+  unsigned int hash;
+  const char *data;
+} revisionToken;
+
+// NOTE: "type" is '=' for kept, '-' for deleted and '+' for inserted tokens, "token" the first one inserted
+typedef struct revisionEdit {
+  char type;
+  unsigned int count;
+  unsigned int token;
+} revisionEdit;
+
+typedef struct revisionDeltas {
+  FILE *deltasFile;
+  unsigned int pageRecord;
+  unsigned int pageRevisions;
+  unsigned int revisionCount;
+  unsigned int hashCount;
+  unsigned int hashSize;
+  unsigned int tokenCount;
+  unsigned int tokenSize;
+  unsigned int editCount;
+  unsigned int editSize;
+  unsigned int traceSize;
+  unsigned int *hashes;
+  struct revisionToken *tokens;
+  struct revisionEdit *edits;
+  int *trace;
+} revisionDeltas;
+
+/*
+  NOTE: Pages of INCREMENTAL runs. "keys" holds the id, sha1 and hash of each
+        page of this run by its record number, the hash is taken over the
+        lines of the page outside its text. "previous" holds the pages of the
+        manifest of the previous run sorted by page id, "reused" the pages of
+        this run left to the rows of the previous run. "lines" keeps the lines
+        outside the text of the page read ahead, '\0' terminated each.
+*/
+typedef struct pageKey {
+  unsigned int pageId;
+  unsigned int hash;
+  bool hasSha1;
+  unsigned char sha1[WICKEDSHA1SIZE];
+} pageKey;
+
+typedef struct previousPage {
+  struct pageKey key;
+  unsigned int startLine;
+  unsigned int endLine;
+  unsigned long long startBytes[OUTPUTFILES];
+  unsigned long long endBytes[OUTPUTFILES];
+} previousPage;
+
+typedef struct reusedPage {
+  unsigned int record;
+  unsigned int previousRecord;
+} reusedPage;
+
+typedef struct incrementalRun {
+  unsigned int keyCount;
+  unsigned int keySize;
+  unsigned int previousCount;
+  unsigned int reusedCount;
+  unsigned int reusedSize;
+  unsigned int linesLength;
+  unsigned int linesSize;
+  size_t lineSize;
+  int previousFiles[OUTPUTFILES];
+  char *line;
+  char *lines;
+  struct pageKey *keys;
+  struct previousPage *previous;
+  struct reusedPage *reused;
+} incrementalRun;
+
+/*
+  NOTE: Page filters set by the options of wicked, a page is parsed if it
+        matches all filters given: one of "namespaces", one of "prefixes" or
+        "titleRegex" for the title, the page id from "firstId" to "lastId".
+        The first "pageLimit" pages matching are parsed, 0 for all.
+*/
+typedef struct pageFilter {
+  bool isActive;
+  bool hasRegex;
+  bool isFinished;
+  unsigned int namespaceCount;
+  unsigned int prefixCount;
+  unsigned int firstId;
+  unsigned int lastId;
+  unsigned int pageLimit;
+  unsigned int pageCount;
+  unsigned int skippedCount;
+  size_t lineSize;
+  short *namespaces;
+  const char **prefixes;
+  char *line;
+  char *title;
+  regex_t titleRegex;
+} pageFilter;
+
+//------------------------------------------------------------------------------
+
+// Columns of the binary write out, see wickedbinary.h
+#pragma pack()
+typedef struct binaryColumn {
+  unsigned char type;
+  unsigned char width;
+  bool hasFailed;
+  size_t length;
+  size_t bufferSize;
+  size_t offsetBuffer;
+  long long lastValue;
+  unsigned char *data;
+  unsigned long long *stringOffsets;
+} binaryColumn;
+
+typedef struct binaryTable {
+  unsigned int kind;
+  unsigned int rowCount;
+  unsigned int columnCount;
+  struct binaryColumn columns[WICKEDMAXCOLUMNS];
+} binaryTable;
+
+//------------------------------------------------------------------------------
+
+// Pending write of a full output buffer
+typedef struct asyncWrite {
+  int fileDescriptor;
+  unsigned int length;
+  unsigned long long offset;
+  const char *data;
+  bool *isPending;
+} asyncWrite;
+
+/*
+  NOTE: Writes full output buffers in the background, by io_uring where the
+        kernel offers it and else by a helper thread using pwrite.
+*/
+typedef struct asyncWriter {
+  bool isRing;
+  bool hasFailed;
+  bool isStopping;
+  unsigned int queueHead;
+  unsigned int queueCount;
+  struct asyncWrite queue[ASYNCQUEUESIZE];
+  // io_uring
+  #if defined(__linux__)
+  int ringDescriptor;
+  unsigned int *sqTail;
+  unsigned int *sqMask;
+  unsigned int *sqArray;
+  unsigned int *cqHead;
+  unsigned int *cqTail;
+  unsigned int *cqMask;
+  void *sqRing;
+  void *cqRing;
+  size_t sqRingSize;
+  size_t cqRingSize;
+  size_t sqesSize;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  #endif
+  // Helper thread
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+} asyncWriter;
+
+// Shards of the write out, each starting at the first line of a page
+typedef struct shardTable {
+  unsigned int count;
+  unsigned int *startLines;
+  unsigned int *firstPages;
+} shardTable;
+
+/*
+  NOTE: Runs of the sorted write out, spilled to files once the parsed data
+        exceeds MEMORYBUDGET. "startLine" is the first line of the next run,
+        "spilledBytes" the estimated size of the data parsed up to the last run.
+*/
+typedef struct sortRuns {
+  unsigned int count;
+  unsigned int startLine;
+  unsigned long long spilledBytes;
+} sortRuns;
+
+// Buffers of the text write out, a full buffer is written while the next one is filled
+typedef struct outputBuffer {
+  int fileDescriptor;
+  unsigned int length;
+  unsigned int size;
+  unsigned short bufferIndex;
+  unsigned long long fileOffset;
+  char *data;
+  char *buffers[OUTPUTBUFFERS];
+  bool isPending[OUTPUTBUFFERS];
+  struct asyncWriter *writer;
+  bool isCompressed;
+  // Set by the first failed write, the rows written after it are incomplete
+  bool hasFailed;
+  // Words are written by their rank in the vocabulary instead of the string if set
+  const struct vocabularyTable *vocabulary;
+  // Wikitag targets by their id
+  const struct targetTable *targets;
+  // Shards, "shardBytes" holds the written bytes of each finished shard
+  const char *fileName;
+  unsigned int shardIndex;
+  unsigned long long *shardBytes;
+  const struct shardTable *shards;
+  // Page index, "pageOffsets" holds the first byte of each page in the file
+  unsigned int pageIndex;
+  unsigned int pageCount;
+  const struct page *pages;
+  unsigned long long *pageOffsets;
+  // Incremental runs, the rows of reused pages are copied from the file of the previous run
+  const struct incrementalRun *incremental;
+  unsigned short fileIndex;
+  unsigned int reusedIndex;
+  // Compression, "writtenBytes" counts the written and "dataBytes" the formatted bytes
+  unsigned long long writtenBytes;
+  unsigned long long dataBytes;
+  #if COMPRESSWRITEOUT != COMPRESSNONE
+  unsigned int compressedSize[OUTPUTBUFFERS];
+  char *compressedBuffers[OUTPUTBUFFERS];
+  #endif
+  #if COMPRESSWRITEOUT == COMPRESSGZIP
+  z_stream compressor;
+  #endif
+} outputBuffer;
+
+//------------------------------------------------------------------------------
+
 typedef struct parserBaseStore {
   FILE* dictFile;
   FILE* wtagFile;
   FILE* xmltagFile;
   FILE* xmldataFile;
   FILE* entitiesFile;
+  FILE* redirectsFile;
+  struct outputBuffer *dictOutput;
+  struct outputBuffer *wtagOutput;
+  struct outputBuffer *xmltagOutput;
+  struct outputBuffer *xmldataOutput;
+  struct outputBuffer *entitiesOutput;
+  struct outputBuffer *redirectsOutput;
   unsigned int currentPosition;
   unsigned int currentLine;
+  unsigned long long inputPosition;
+  unsigned long long lineEndPosition;
+  unsigned int pageId;
+  unsigned int pageWordCount;
+  unsigned int pageTitleBuffer;
+  char *pageTitle;
   bool isMathSection;
+  bool skipData;
+  short openInlineSpan;
+  struct openWikiTagState openWikiTag;
+  struct namespaceTable* namespaces;
   struct xmlDataCollection* xmlCollection;
   struct collectionStatistics* cData;
+  struct sortRuns* runs;
+  struct vocabularyTable* vocabulary;
+  struct linkTable* links;
+  struct targetTable* targets;
+  struct sharedTagTable* sharedTags;
+  struct formatSpanTable* formatSpans;
+  struct sectionTable* sections;
+  struct parameterTable* parameters;
+  struct metadataTable* metadata;
+  struct revisionDeltas* deltas;
+  bool isPageEnd;
 } parserBaseStore;
 
 //------------------------------------------------------------------------------
@@ -252,7 +909,12 @@ const char wikiTagNames[TAGTYPES][19] = {
   "Wikipedia",
   "Special",
   "User",
-  "Link"
+  "Link",
+  "Reference",
+  "Table row",
+  "Table cell",
+  "Table header",
+  "Table caption"
 };
 
 const char tagTypes[TAGTYPES][18] = {
@@ -265,20 +927,108 @@ const char tagTypes[TAGTYPES][18] = {
   "[[file:",
   "[[image:", // [[Image:LeoTolstoy.jpg|thumb|150px|[[Leo Tolstoy|Leo Tolstoy]] 1828-1910]]
   "[[sound:", // Media types end
-  //"#REDIRECT", // Redirect #REDIRECT [[United States]] (article) --- #REDIRECT [[United States#History]] (section)
+  // NOTE: Redirects are handled by addRedirect => #REDIRECT [[United States]] (article) --- #REDIRECT [[United States#History]] (section)
   "[[wiktionary:", // [[wiktionary:terrace|terrace]]s
   "[[wikipedia:", // [[Wikipedia:Nupedia and Wikipedia]]
   "[[special:",
   "[[user:",
-  "[[" // Link => [[Autistic community#Declaration from the autism community|sent a letter to the United Nations]]
+  "[[", // Link => [[Autistic community#Declaration from the autism community|sent a letter to the United Nations]]
+  // NOTE: References are only created by the inline span scanner of parseXMLData
+  "&lt;ref", // Reference => &lt;ref name=&quot;x&quot;&gt;{{cite web|...}}&lt;/ref&gt;
+  // NOTE: Table elements are only created by addWikiTable
+  "|-", // Table row
+  "|", // Table cell, multiple cells in one line are seperated by "||"
+  "!", // Table header cell, multiple cells in one line are seperated by "!!"
+  "|+" // Table caption
+};
+
+/*
+  NOTE: The "[[name:" tag types above seed the namespace table with the key of
+        their namespace. Image and Sound are older names of the File and Media
+        namespaces and keep their own tag type.
+*/
+const short namespaceTagTypes[NAMESPACETAGTYPES][2] = {
+  // {namespace key, tag type}
+  {14, 3}, // Category
+  {-2, 4}, // Media
+  {6, 5}, // File
+  {6, 6}, // Image
+  {-2, 7}, // Sound
+  {INTERWIKIKEY, 8}, // Wiktionary is an interwiki prefix, not a namespace
+  {4, 9}, // Wikipedia (project namespace)
+  {-1, 10}, // Special
+  {2, 11} // User
+};
+
+/*
+  NOTE: The one tag type of each key, the namespaces of the dump and the aliases
+        below get the tag type of their key. Namespaces of other keys, like
+        talk pages or templates, are regular links.
+*/
+const short namespaceKeyTagTypes[NAMESPACEKEYS][2] = {
+  // {namespace key, tag type}
+  {14, 3}, // Category
+  {-2, 4}, // Media
+  {6, 5}, // File
+  {INTERWIKIKEY, 8}, // Wiktionary
+  {4, 9}, // Wikipedia
+  {-1, 10}, // Special
+  {2, 11} // User
+};
+
+const char namespaceAliases[NAMESPACEALIASES][16] = {
+  "Project", // Wikipedia
+  "WP", // Wikipedia
+  "Wikt" // Wiktionary
 };
 
+const short namespaceAliasKeys[NAMESPACEALIASES] = {4, 4, INTERWIKIKEY};
+
 const char tagClosingsTypes[TAGCLOSINGS][3] = {
   "}}",
   "]]",
   "|}"
 };
 
+/*
+  NOTE: Escaped inline html which is kept as one span. The names follow the
+        "&lt;" of the opening, the closings are searched for as they are.
+        Only the reference span (REFSPAN) is parsed further as wikitag.
+*/
+const char inlineSpanNames[INLINESPANS][8] = {
+  "!--", // &lt;!-- comment --&gt;
+  "nowiki",
+  "pre",
+  "ref"
+};
+
+const char inlineSpanClosings[INLINESPANS][16] = {
+  "--&gt;",
+  "&lt;/nowiki&gt;",
+  "&lt;/pre&gt;",
+  "&lt;/ref&gt;"
+};
+
+// NOTE: Multibyte punctuation in UTF-8, ASCII punctuation is found by ispunct
+const char punctuations[PUNCTUATIONS][4] = {
+  "\xC2\xA1", // ¡
+  "\xC2\xAB", // «
+  "\xC2\xB7", // ·
+  "\xC2\xBB", // »
+  "\xC2\xBF", // ¿
+  "\xE2\x80\x93", // –
+  "\xE2\x80\x94", // —
+  "\xE2\x80\x98", // ‘
+  "\xE2\x80\x99", // ’
+  "\xE2\x80\x9A", // ‚
+  "\xE2\x80\x9C", // “
+  "\xE2\x80\x9D", // ”
+  "\xE2\x80\x9E", // „
+  "\xE2\x80\xA6", // …
+  "\xE3\x80\x81", // 、
+  "\xE3\x80\x82"  // 。
+};
+
 const char entities[ENTITIES][2][32] = {
   //Commercial symbols
   {"trade", "\xe2\x84\xa2"},
@@ -513,19 +1263,221 @@ int parseXMLData(const unsigned int, const unsigned int, const char*, struct xml
 bool addWikiTag(const short, void*, const short, const short, const bool, const bool, const short, const unsigned char, const unsigned char, const bool, const char*, struct parserBaseStore*);
 bool addEntity(const short, void*, const short, const short, const bool, const bool, const unsigned char, unsigned const char, const bool, const char*, struct parserBaseStore*);
 bool addWord(const short, void*, const short, const short, const bool, const bool, const unsigned char, const unsigned char, const bool, const char*, struct parserBaseStore*);
+bool addWordData(const short, void*, const short, const short, const bool, const bool, const unsigned char, const unsigned char, const bool, const char*, struct parserBaseStore*);
+
+// UTF-8 and punctuation
+unsigned int validateUTF8(const char*, const unsigned int, char*, unsigned int*);
+unsigned short punctuationLength(const char*, const unsigned int);
+
+// Wikitags open over multiple lines and tables
+bool addWikiTable(const short, void*, const short, const short, const bool, const bool, const unsigned char, const unsigned char, const bool, const char*, struct parserBaseStore*);
+unsigned int readWikiTable(const unsigned int, const unsigned int, const char*, char*, unsigned int*, unsigned short*);
+unsigned int findTableSeparator(const char*, unsigned int, const unsigned int, const char*);
+struct wikiTag* addTableCell(struct wikiTag*, struct wikiTag*, const short, const char*, const unsigned int, const unsigned int, struct parserBaseStore*);
+void appendWikiTagData(struct openWikiTagState*, const char*, const unsigned int);
+
+// Page information and redirects
+void readNodeInfo(const struct xmlNode*, const char*, struct parserBaseStore*);
+void readPageTitle(const char*, struct parserBaseStore*);
+void addPage(struct parserBaseStore*);
+bool addRedirect(const char*, struct parserBaseStore*);
+
+// Namespaces
+void initNamespaces(struct namespaceTable*);
+void addNamespace(struct namespaceTable*, const char*, const unsigned int, const short, const short);
+void addSiteNamespace(const struct xmlNode*, const char*, struct namespaceTable*);
+struct namespaceEntry* findNamespace(const struct namespaceTable*, const char*, const unsigned int);
+short findWikiTagType(const char*, const char*, short*, const struct namespaceTable*);
+short namespaceTagType(const short);
+void freeNamespaces(struct namespaceTable*);
+
+// Vocabulary
+void initVocabulary(struct vocabularyTable*);
+struct vocabularyEntry* addVocabularyWord(struct vocabularyTable*, const char*);
+void addPosting(struct vocabularyEntry*, const unsigned int, const unsigned int);
+unsigned long long translatePostings(const struct vocabularyEntry*, const struct xmlDataCollection*, FILE*);
+bool writeOutInvertedIndex(const struct vocabularyTable*, const struct xmlDataCollection*);
+void growVocabulary(struct vocabularyTable*);
+struct vocabularyEntry* findVocabularyWord(const struct vocabularyTable*, const char*);
+int compareVocabularyWords(const void*, const void*);
+int compareVocabularyCounts(const void*, const void*);
+bool rankVocabulary(struct vocabularyTable*);
+bool writeOutVocabulary(const struct vocabularyTable*);
+void writeVarint(FILE*, unsigned long long);
+void freeVocabulary(struct vocabularyTable*);
+
+// Wikitag targets
+void initTargets(struct targetTable*);
+unsigned int internTarget(struct targetTable*, const char*, const short);
+void growTargets(struct targetTable*);
+unsigned int normalizeTitle(char*, const char*, const bool);
+bool writeOutTargets(const struct targetTable*);
+void freeTargets(struct targetTable*);
+
+// Shared wikitag subtrees
+void initSharedTags(struct sharedTagTable*);
+void shareWikiTag(struct sharedTagTable*, struct wikiTag*);
+bool isShareableTag(const struct wikiTag*);
+unsigned int hashTagChildren(const struct wikiTag*);
+bool isSameTagChildren(const struct wikiTag*, const struct wikiTag*);
+void growSharedTags(struct sharedTagTable*);
+void freeSharedTags(struct sharedTagTable*);
+
+// Format spans
+void initFormatSpans(struct formatSpanTable*);
+void addNodeFormatSpans(struct formatSpanTable*, const struct xmlNode*);
+void addTagFormatTokens(struct formatSpanTable*, const struct wikiTag*);
+void addFormatSpan(struct formatSpanTable*, const struct formatToken*, const struct formatToken*, const short);
+int compareFormatTokens(const void*, const void*);
+int compareFormatSpans(const void*, const void*);
+bool writeOutFormatSpans(const struct formatSpanTable*);
+void freeFormatSpans(struct formatSpanTable*);
+
+// Section index
+void initSections(struct sectionTable*);
+void addHeadingLine(struct sectionTable*, const unsigned int, const unsigned long long);
+void addNodeSections(struct sectionTable*, const struct xmlNode*, const struct parserBaseStore*);
+void addTagSectionTokens(struct sectionTable*, const struct wikiTag*);
+struct section* addSection(struct sectionTable*, const unsigned int, const unsigned short, const struct sectionToken*, const unsigned long long);
+unsigned int findSectionToken(const struct sectionTable*, const unsigned int);
+int compareSectionTokens(const void*, const void*);
+bool writeOutSections(const struct sectionTable*);
+void freeSections(struct sectionTable*);
+
+// Template parameters
+void initParameters(struct parameterTable*);
+void addTemplateParameters(struct parameterTable*, const struct wikiTag*, const char*, const unsigned int);
+void addParameter(struct parameterTable*, const struct wikiTag*, const unsigned int, const unsigned short, const char*, const char*, const unsigned int);
+unsigned int copyParameterText(char*, const char*, const unsigned int);
+bool writeOutParameters(const struct parameterTable*, const struct targetTable*);
+void freeParameters(struct parameterTable*);
+
+// Page metadata
+bool readPageMetadata(const char*, struct parserBaseStore*);
+bool readMetadataLine(const char*, struct parserBaseStore*);
+long long parseTimestamp(const char*);
+bool parseSha1(unsigned char*, const char*, const unsigned int);
+bool writeOutMetadata(const struct metadataTable*, const struct xmlDataCollection*);
+void freeMetadata(struct metadataTable*);
+
+// Revision deltas
+void initRevisionDeltas(struct revisionDeltas*, FILE*);
+void addRevisionDelta(struct revisionDeltas*, struct xmlNode*, const struct parserBaseStore*);
+void addRevisionTagTokens(struct revisionDeltas*, const struct wikiTag*, const struct targetTable*);
+void diffRevisionTokens(struct revisionDeltas*);
+bool diffRevisionMiddle(struct revisionDeltas*, const unsigned int, const unsigned int, const unsigned int);
+void addRevisionEdit(struct revisionDeltas*, const char, const unsigned int, const unsigned int);
+int compareRevisionTokens(const void*, const void*);
+void freeRevisionDeltas(struct revisionDeltas*);
+
+// Incremental runs
+void initIncremental(struct incrementalRun*);
+bool readPreviousRun(struct incrementalRun*, struct outputBuffer**);
+bool skipUnchangedPage(const char*, FILE*, struct incrementalRun*, struct parserBaseStore*, unsigned long long*);
+int comparePreviousPages(const void*, const void*);
+unsigned int revisionManifestHeader(char*, const unsigned int, struct outputBuffer**);
+void copyReusedRows(struct outputBuffer*);
+void finishReusedRows(struct outputBuffer*);
+bool writeOutRevisionManifest(const struct incrementalRun*, struct outputBuffer**, const struct xmlDataCollection*);
+void freeIncremental(struct incrementalRun*);
+
+// Page filters
+bool readPageFilters(struct pageFilter*, int, char**);
+bool skipFilteredPage(const char*, FILE*, struct pageFilter*, struct parserBaseStore*, unsigned long long*);
+bool isPageMatching(const struct pageFilter*, const char*, const short, const unsigned int);
+void freePageFilters(struct pageFilter*);
+
+// Link graph
+void initLinks(struct linkTable*);
+void addLink(struct linkTable*, const unsigned int, const unsigned int);
+bool writeOutLinkGraph(const struct linkTable*, const struct targetTable*, const struct xmlDataCollection*);
+void freeLinks(struct linkTable*);
+
+// Inline html spans
+short findInlineSpan(const char*, const unsigned int, bool*);
+unsigned int findSequence(const char*, const unsigned int, const unsigned int, const char*);
+unsigned int readInlineSpan(const short, const unsigned int, const unsigned int, const unsigned int, const char*, char*, unsigned int*, struct parserBaseStore*);
 
 // Writeout
 bool writeOutDataFiles(const struct parserBaseStore*, struct xmlDataCollection*);
 bool writeOutTagData(const struct parserBaseStore*, struct wikiTag*);
 bool writeOutTagDataByLine(const struct parserBaseStore*, struct wikiTag*, const unsigned int);
 
+// Buffered text write out
+void initOutputBuffer(struct outputBuffer*, FILE*, const char*, struct asyncWriter*);
+bool writeOutputData(const int, const char*, const unsigned int, const unsigned long long);
+bool flushOutputBuffer(struct outputBuffer*, const bool);
+bool closeOutputBuffer(struct outputBuffer*);
+bool finishOutputFile(struct outputBuffer*);
+unsigned int compressOutput(struct outputBuffer*, const bool);
+void reportOutputBuffer(const struct outputBuffer*);
+void appendOutput(struct outputBuffer*, const char*, const unsigned int);
+void appendHex(struct outputBuffer*, unsigned int);
+void appendDecimal(struct outputBuffer*, const long long);
+void outputWordRow(struct outputBuffer*, const struct word*, const long long, const unsigned char);
+void outputEntityRow(struct outputBuffer*, const struct entity*, const long long, const unsigned char);
+void outputTagRow(struct outputBuffer*, const struct wikiTag*);
+void outputNodeRow(struct outputBuffer*, const struct xmlNode*, const bool);
+void outputPairRow(struct outputBuffer*, const unsigned int, const unsigned int, const unsigned int, const char*, const char*, const bool);
+
+// Shards of the write out
+void buildOutputShards(const struct xmlDataCollection*, struct shardTable*);
+void selectOutputShard(struct outputBuffer*, const unsigned int);
+bool openOutputShard(struct outputBuffer*);
+void shardFileName(char*, const char*, const unsigned int);
+bool writeOutManifest(struct outputBuffer**, const struct shardTable*, const struct xmlDataCollection*, const unsigned int);
+void freeOutputShards(struct shardTable*);
+
+// Sorted write out in runs
+void writeOutSortedRows(const struct parserBaseStore*, struct xmlDataCollection*, const unsigned int, const bool*);
+unsigned long long collectedBytes(const struct collectionStatistics*, const struct xmlDataCollection*);
+bool spillSortedRun(const struct parserBaseStore*, struct xmlDataCollection*, const bool);
+bool mergeSortedRuns(const struct parserBaseStore*);
+void runFileName(char*, const unsigned int, const unsigned short);
+unsigned int readRowKey(const char*, const unsigned short);
+
+// Page index of the text write out
+bool writeOutPageIndex(struct outputBuffer**, const struct xmlDataCollection*);
+int comparePageIds(const void*, const void*);
+int comparePageTitles(const void*, const void*);
+
+// Asynchronous write out
+bool initAsyncWriter(struct asyncWriter*);
+bool initWriteRing(struct asyncWriter*);
+void submitAsyncWrite(struct asyncWriter*, const int, const char*, const unsigned int, const unsigned long long, bool*);
+void waitAsyncWrite(struct asyncWriter*, bool*);
+void reapWriteRing(struct asyncWriter*);
+void* asyncWriteThread(void*);
+void closeAsyncWriter(struct asyncWriter*);
+
+// Binary write out
+bool writeOutBinaryFiles(const struct parserBaseStore*, struct xmlDataCollection*);
+void writeOutBinaryTag(struct binaryTable*, struct binaryTable*, struct binaryTable*, const struct targetTable*, const struct wikiTag*, const int);
+void addBinaryWord(struct binaryTable*, const struct word*, const int);
+void addBinaryEntity(struct binaryTable*, const struct entity*, const int);
+void initBinaryTable(struct binaryTable*, const unsigned int, const unsigned int, const unsigned char*, const unsigned char*);
+void addBinaryValue(struct binaryTable*, const unsigned int, const long long);
+void addBinaryString(struct binaryTable*, const unsigned int, const char*);
+bool growBinaryColumn(struct binaryColumn*, const size_t);
+void writeBinaryUnsigned(FILE*, unsigned long long, const unsigned short);
+bool writeBinaryTable(FILE*, struct binaryTable*);
+
 // Clean up functions
 void freeXMLCollection(struct xmlDataCollection*);
+void freeXMLNode(struct xmlNode*);
+void freeXMLNodeTokens(struct xmlNode*);
 void freeXMLCollectionTag(wikiTag*);
 
 //------------------------------------------------------------------------------
 // Main routine
 int main(int argc, char *argv[]) {
+  pageFilter filter;
+  if (!readPageFilters(&filter, argc, argv)) {
+    fprintf(stderr, "Usage: %s [-n namespace,...] [-p title prefix]... [-r title regex] [-i first id-last id] [-c pages]\n", argv[0]);
+    freePageFilters(&filter);
+    return 1;
+  }
+
   printf("[ INFO ] Starting parsing process on file \"%s\".\n", SOURCEFILE);
 
   FILE *inputFile = fopen(SOURCEFILE, "r");
@@ -535,20 +1487,46 @@ int main(int argc, char *argv[]) {
   FILE *xmltagFile = NULL;
   FILE *xmldataFile = NULL;
   FILE *entitiesFile = NULL;
-
-  if (DOWRITEOUT) {
+  FILE *redirectsFile = NULL;
+
+  outputBuffer dictOutput, wtagOutput, xmltagOutput, xmldataOutput, entitiesOutput, redirectsOutput;
+  outputBuffer *outputs[OUTPUTFILES] = {&dictOutput, &wtagOutput, &xmltagOutput, &xmldataOutput, &entitiesOutput, &redirectsOutput};
+  asyncWriter writer;
+  asyncWriter *outputWriter = NULL;
+  shardTable shards = {0, NULL, NULL};
+  const bool isSharded = (SHARDCOUNT != 0 || SHARDPAGES != 0 || SHARDBYTES != 0) && !BINARYWRITEOUT;
+  // NOTE: The byte ranges of the page index are positions in uncompressed files
+  const bool isPageIndexed = PAGEINDEX && COMPRESSWRITEOUT == COMPRESSNONE;
+
+  if (DOWRITEOUT && !LINKSONLY) {
     remove(DICTIONARYFILE);
     remove(WIKITAGSFILE);
     remove(XMLTAGFILE);
     remove(XMLDATAFILE);
     remove(ENTITIESFILE);
+    if (REDIRECTTABLE) remove(REDIRECTSFILE);
+  }
+
+  // NOTE: Shards open their own files once the write out starts
+  if (DOWRITEOUT && !isSharded && !LINKSONLY) {
     dictFile = fopen(DICTIONARYFILE, "w");
     wtagFile = fopen(WIKITAGSFILE, "w");
     xmltagFile = fopen(XMLTAGFILE, "w");
     xmldataFile = fopen(XMLDATAFILE, "w");
     entitiesFile = fopen(ENTITIESFILE, "w");
+    if (REDIRECTTABLE) redirectsFile = fopen(REDIRECTSFILE, "w");
   }
 
+  if (DOWRITEOUT && ASYNCWRITEOUT && !BINARYWRITEOUT && !LINKSONLY && initAsyncWriter(&writer)) outputWriter = &writer;
+
+  initOutputBuffer(&dictOutput, dictFile, DICTIONARYFILE, outputWriter);
+  initOutputBuffer(&wtagOutput, wtagFile, WIKITAGSFILE, outputWriter);
+  initOutputBuffer(&xmltagOutput, xmltagFile, XMLTAGFILE, outputWriter);
+  initOutputBuffer(&xmldataOutput, xmldataFile, XMLDATAFILE, outputWriter);
+  initOutputBuffer(&entitiesOutput, entitiesFile, ENTITIESFILE, outputWriter);
+  // NOTE: Without REDIRECTTABLE the redirects output has no file and no rows
+  initOutputBuffer(&redirectsOutput, redirectsFile, REDIRECTSFILE, outputWriter);
+
   collectionStatistics cData = {0};
 
   if (inputFile == NULL) {
@@ -563,10 +1541,68 @@ int main(int argc, char *argv[]) {
   char *line = malloc(sizeof(char) * LINEBUFFERBASE);
 
   unsigned int lineLength = 0;
-  char tmpChar = '\0';
+  unsigned int invalidCount = 0;
+  unsigned long long inputBytes = 0;
+  int tmpChar = '\0';
   unsigned int readerPos = 0;
 
-  xmlDataCollection xmlCollection = {0, 0, NULL, NULL};
+  xmlDataCollection xmlCollection = {0, 0, 0, 0, NULL, NULL, NULL, NULL};
+
+  namespaceTable namespaces = {0, 0, NULL};
+  initNamespaces(&namespaces);
+
+  vocabularyTable vocabulary = {0, 0, NULL};
+  if (VOCABULARY && !LINKSONLY) initVocabulary(&vocabulary);
+
+  targetTable targets = {0, 0, NULL, NULL, NULL};
+  initTargets(&targets);
+  wtagOutput.targets = &targets;
+
+  linkTable links = {0, 0, NULL, NULL};
+  if (LINKGRAPH) initLinks(&links);
+
+  sharedTagTable sharedTags = {0, 0, 0, NULL};
+  if (SHARETAGS) initSharedTags(&sharedTags);
+
+  formatSpanTable formatSpans = {0, 0, 0, 0, NULL, NULL};
+  if (FORMATSPANS && !LINKSONLY) initFormatSpans(&formatSpans);
+
+  sectionTable sections = {0, 0, 0, 0, 0, 0, 0, NULL, NULL, NULL, NULL};
+  if (SECTIONINDEX && !LINKSONLY) initSections(&sections);
+
+  parameterTable parameters = {0, 0, {0, 0, NULL, NULL, NULL}, NULL};
+  if (TEMPLATEPARAMETERS && !LINKSONLY) initParameters(&parameters);
+
+  metadataTable metadata = {0, 0, false, false, NULL};
+
+  revisionDeltas deltas = {NULL, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, NULL, NULL, NULL, NULL};
+  if (REVISIONDELTAS && !LINKSONLY) {
+    if (DOWRITEOUT) remove(REVISIONDELTASFILE);
+    initRevisionDeltas(&deltas, DOWRITEOUT ? fopen(REVISIONDELTASFILE, "w") : NULL);
+  }
+
+  /*
+    NOTE: Rows are copied from the sorted text files of the previous run, so the
+          write out has to match them. Tables over all pages would only hold the
+          parsed pages, so they rule out incremental runs.
+  */
+  const bool isIncremental = INCREMENTAL && DOWRITEOUT && isPageIndexed && !STRAIGHTWRITEOUT && !BINARYWRITEOUT && !LINKSONLY && !isSharded && !WORDIDS && !TARGETIDS
+    && !VOCABULARY && !LINKGRAPH && !FORMATSPANS && !SECTIONINDEX && !TEMPLATEPARAMETERS && !REVISIONDELTAS;
+  incrementalRun incremental = {0, 0, 0, 0, 0, 0, 0, 0, {-1, -1, -1, -1, -1, -1}, NULL, NULL, NULL, NULL, NULL};
+  if (INCREMENTAL && !isIncremental) printf("[ ERROR ] INCREMENTAL does not work with the switches set, all pages are parsed.\n");
+  if (PAGEINDEX && !isPageIndexed) printf("[ ERROR ] PAGEINDEX does not work with COMPRESSWRITEOUT, no page index is written.\n");
+  if (isIncremental) {
+    initIncremental(&incremental);
+    if (readPreviousRun(&incremental, outputs)) printf("[STATUS] %d PAGES OF THE PREVIOUS RUN IN %s\n", incremental.previousCount, PREVIOUSDIRECTORY);
+    else printf("[STATUS] NO PREVIOUS RUN IN %s, ALL PAGES ARE PARSED\n", PREVIOUSDIRECTORY);
+
+    for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+      outputs[i]->incremental = &incremental;
+      outputs[i]->fileIndex = i;
+    }
+  }
+
+  sortRuns runs = {0, 1, 0};
 
   parserBaseStore parserRunTimeData;
   parserRunTimeData.dictFile = dictFile;
@@ -574,22 +1610,53 @@ int main(int argc, char *argv[]) {
   parserRunTimeData.xmltagFile = xmltagFile;
   parserRunTimeData.xmldataFile = xmldataFile;
   parserRunTimeData.entitiesFile = entitiesFile;
+  parserRunTimeData.redirectsFile = redirectsFile;
+  parserRunTimeData.dictOutput = &dictOutput;
+  parserRunTimeData.wtagOutput = &wtagOutput;
+  parserRunTimeData.xmltagOutput = &xmltagOutput;
+  parserRunTimeData.xmldataOutput = &xmldataOutput;
+  parserRunTimeData.entitiesOutput = &entitiesOutput;
+  parserRunTimeData.redirectsOutput = &redirectsOutput;
   parserRunTimeData.xmlCollection = &xmlCollection;
+  parserRunTimeData.namespaces = &namespaces;
   parserRunTimeData.cData = &cData;
+  parserRunTimeData.runs = &runs;
+  parserRunTimeData.vocabulary = &vocabulary;
+  parserRunTimeData.links = &links;
+  parserRunTimeData.targets = &targets;
+  parserRunTimeData.sharedTags = &sharedTags;
+  parserRunTimeData.formatSpans = &formatSpans;
+  parserRunTimeData.sections = &sections;
+  parserRunTimeData.parameters = &parameters;
+  parserRunTimeData.metadata = &metadata;
+  parserRunTimeData.deltas = &deltas;
+  parserRunTimeData.isPageEnd = false;
   parserRunTimeData.currentPosition = 0;
+  parserRunTimeData.inputPosition = 0;
+  parserRunTimeData.lineEndPosition = 0;
   parserRunTimeData.currentLine = 1;
+  parserRunTimeData.pageId = 0;
+  parserRunTimeData.pageWordCount = 0;
+  parserRunTimeData.pageTitleBuffer = 0;
+  parserRunTimeData.pageTitle = NULL;
   parserRunTimeData.isMathSection = false;
+  parserRunTimeData.skipData = false;
+  parserRunTimeData.openInlineSpan = -1;
+  parserRunTimeData.openWikiTag = (openWikiTagState) {0, 0, 0, 0, 0, 0, -1, -1, -1, false, false, 0, NULL};
 
   //----------------------------------------------------------------------------
   // Parser start
   while (tmpChar != EOF) {
     lineLength = 0;
+    parserRunTimeData.inputPosition = inputBytes;
 
     if (LINESTOPROCESS != 0 && parserRunTimeData.currentLine > LINESTOPROCESS) break;
+    if (filter.isFinished) break;
 
     // Read a line from file
     do {
       tmpChar = fgetc(inputFile);
+      ++inputBytes;
       if (tmpChar == ' ' || tmpChar == '\t') {
         ++cData.byteWhitespace;
         if (lineLength == 0) continue;
@@ -605,7 +1672,15 @@ int main(int argc, char *argv[]) {
 
     } while (tmpChar != '\r' && tmpChar != '\n' && tmpChar != EOF);
 
+    parserRunTimeData.lineEndPosition = inputBytes;
+
     if (line[0] == '\n' || line[0] == '\r') {
+      // NOTE: A blank line ends the paragraph and with it any wikitag still open
+      if (parserRunTimeData.openWikiTag.wikiTagType != -1 && !parserRunTimeData.skipData) {
+        line[lineLength] = '\0';
+        parseXMLData(0, lineLength, line, &xmlCollection.nodes[xmlCollection.count-1], &parserRunTimeData);
+      }
+
       ++cData.byteNewLine;
       ++parserRunTimeData.currentLine;
       parserRunTimeData.currentPosition = 0;
@@ -615,13 +1690,37 @@ int main(int argc, char *argv[]) {
     line[lineLength] = '\0';
     ++cData.byteNewLine;
     parserRunTimeData.currentPosition = 0;
-    parserRunTimeData.isMathSection = false;
+
+    // NOTE: Invalid UTF-8 becomes U+FFFD, so no invalid bytes reach the words and the vocabulary
+    if ((invalidCount = validateUTF8(line, lineLength, NULL, NULL)) != 0) {
+      char *replacedLine = malloc(sizeof(char) * (lineBuffer + 2 * invalidCount));
+      validateUTF8(line, lineLength, replacedLine, &lineLength);
+      free(line);
+      line = replacedLine;
+      lineBuffer += 2 * invalidCount;
+      cData.invalidUTF8 += invalidCount;
+    }
 
     // Find XML Tags on line
     if (line[0] != '<') {
-      readerPos = parseXMLData(0, lineLength, line, &xmlCollection.nodes[xmlCollection.count-1], &parserRunTimeData);
+      if (SECTIONINDEX && !LINKSONLY && line[0] == '=' && !parserRunTimeData.skipData) addHeadingLine(&sections, parserRunTimeData.currentLine, parserRunTimeData.inputPosition);
+
+      if (parserRunTimeData.skipData) readerPos = strcspn(line, "<");
+      else readerPos = parseXMLData(0, lineLength, line, &xmlCollection.nodes[xmlCollection.count-1], &parserRunTimeData);
       if (readerPos < lineLength - 1) parseXMLNode(readerPos, lineLength, &line[readerPos], &parserRunTimeData, true);
-    } else parseXMLNode(0, lineLength, line, &parserRunTimeData, false);
+    } else if (filter.isActive && skipFilteredPage(line, inputFile, &filter, &parserRunTimeData, &inputBytes)) {
+      // NOTE: The page is skipped up to its end without being parsed
+    } else if (isIncremental && skipUnchangedPage(line, inputFile, &incremental, &parserRunTimeData, &inputBytes)) {
+      // NOTE: The page is read up to its end, its rows are copied from the previous run
+    } else if (!PAGEMETADATA || !readPageMetadata(line, &parserRunTimeData)) parseXMLNode(0, lineLength, line, &parserRunTimeData, false);
+
+    // NOTE: Sorted runs are spilled between pages only, the rows of a run which failed stay in memory for the next one
+    if (parserRunTimeData.isPageEnd) {
+      if (DOWRITEOUT && MEMORYBUDGET != 0 && !LINKSONLY && !STRAIGHTWRITEOUT && !BINARYWRITEOUT && collectedBytes(&cData, &xmlCollection) - runs.spilledBytes >= MEMORYBUDGET) {
+        spillSortedRun(&parserRunTimeData, &xmlCollection, false);
+      }
+      parserRunTimeData.isPageEnd = false;
+    }
 
     ++parserRunTimeData.currentLine;
   }
@@ -633,33 +1732,152 @@ int main(int argc, char *argv[]) {
   long int durMinutes = floor((duration % 3600) / 60);
   long int durSeconds = (duration % 3600) % 60;
   printf("\n\n[STATUS] RUN TIME FOR PARSING PROCESS: %ldh %ldm %lds\n", durHours, durMinutes, durSeconds);
-  printf("[REPORT] PARSED LINES : %d | FAILED ELEMENTS: %d\n", parserRunTimeData.currentLine, cData.failedElements);
-  printf("[REPORT] FILE STATISTICS\nXML TAG    : %16d [ %.3lf MB]\nKEYS       : %16d [ %.3lf MB]\nVALUES     : %16d [ %.3lf MB]\nWORDS      : %16d [ %.3lf MB]\nENTITIES   : %16d [ %.3lf MB]\nWIKITAGS   : %16d [ %.3lf MB]\nWHITESPACE : %16d [ %.3lf MB]\nNEWLINE    : %16d [ %.3lf MB]\nFORMATTING : [ %.3lf MB]\n\nTOTAL COLLECTED DATA : ~%.3lf MB\n", xmlCollection.count, cData.byteXMLsaved / 1000000.0, cData.keyCount, cData.byteKeys / 1000000.0, cData.valueCount, cData.byteValues / 1000000.0, cData.wordCount, cData.byteWords / 1000000.0, cData.entityCount, cData.byteEntites / 1000000.0, cData.wikiTagCount, cData.byteWikiTags / 1000000.0, cData.byteWhitespace, cData.byteWhitespace / 1000000.0, cData.byteNewLine, cData.byteNewLine / 1000000.0, cData.byteFormatting / 1000000.0, (cData.byteKeys + cData.byteValues + cData.byteWords + cData.byteEntites + cData.byteWikiTags + cData.byteWhitespace + cData.byteFormatting + cData.bytePreWhiteSpace + cData.byteNewLine + cData.byteXMLsaved) / 1000000.0);
+  printf("[REPORT] PARSED LINES : %d | FAILED ELEMENTS: %d | INVALID UTF-8: %d\n", parserRunTimeData.currentLine, cData.failedElements, cData.invalidUTF8);
+  if (filter.isActive) printf("[REPORT] %d PAGES MATCHING THE FILTERS | %d PAGES SKIPPED%s\n", filter.pageCount, filter.skippedCount, filter.isFinished ? " | STOPPED AT THE PAGE LIMIT" : "");
+  printf("[REPORT] FILE STATISTICS\nXML TAG    : %16d [ %.3lf MB]\nKEYS       : %16d [ %.3lf MB]\nVALUES     : %16d [ %.3lf MB]\nWORDS      : %16d [ %.3lf MB]\nENTITIES   : %16d [ %.3lf MB]\nWIKITAGS   : %16d [ %.3lf MB]\nREDIRECTS  : %16d [ %.3lf MB]\nWHITESPACE : %16d [ %.3lf MB]\nNEWLINE    : %16d [ %.3lf MB]\nFORMATTING : [ %.3lf MB]\n\nTOTAL COLLECTED DATA : ~%.3lf MB\n", xmlCollection.count + cData.spilledNodes, cData.byteXMLsaved / 1000000.0, cData.keyCount, cData.byteKeys / 1000000.0, cData.valueCount, cData.byteValues / 1000000.0, cData.wordCount, cData.byteWords / 1000000.0, cData.entityCount, cData.byteEntites / 1000000.0, cData.wikiTagCount, cData.byteWikiTags / 1000000.0, xmlCollection.redirectCount, cData.byteRedirects / 1000000.0, cData.byteWhitespace, cData.byteWhitespace / 1000000.0, cData.byteNewLine, cData.byteNewLine / 1000000.0, cData.byteFormatting / 1000000.0, (cData.byteKeys + cData.byteValues + cData.byteWords + cData.byteEntites + cData.byteWikiTags + cData.byteRedirects + cData.byteWhitespace + cData.byteFormatting + cData.bytePreWhiteSpace + cData.byteNewLine + cData.byteXMLsaved) / 1000000.0);
   printf("TOTAL FILE SIZE: %.3lf MB\n\n", ftell(inputFile) / 1000000.0);
+  if (SHARETAGS) printf("[REPORT] %d WIKITAGS SHARE %d SUBTREES\n\n", sharedTags.useCount, sharedTags.count);
   fclose(inputFile);
 
+  bool isWritten = true;
+
   if (DOWRITEOUT) {
     startTime = time(NULL);
-    writeOutDataFiles(&parserRunTimeData, &xmlCollection);
-    fclose(parserRunTimeData.dictFile);
-    fclose(parserRunTimeData.wtagFile);
-    fclose(parserRunTimeData.xmltagFile);
-    fclose(parserRunTimeData.xmldataFile);
-    fclose(parserRunTimeData.entitiesFile);
+
+    if (VOCABULARY && !LINKSONLY && rankVocabulary(&vocabulary)) {
+      printf("[REPORT] %d WORDS RANKED IN %s\n", vocabulary.count, RANKEDDICTIONARYFILE);
+      if (WORDIDS) dictOutput.vocabulary = &vocabulary;
+    }
+
+    // NOTE: Without words and entities only the link graph is written
+    if (LINKSONLY) {
+      for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+        if (!closeOutputBuffer(outputs[i])) isWritten = false;
+      }
+    } else if (BINARYWRITEOUT) isWritten = writeOutBinaryFiles(&parserRunTimeData, &xmlCollection);
+    else {
+      if (isSharded) {
+        buildOutputShards(&xmlCollection, &shards);
+        for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+          if (REDIRECTTABLE || outputs[i] != &redirectsOutput) outputs[i]->shards = &shards;
+        }
+      }
+
+      if (isPageIndexed) {
+        for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+          outputs[i]->pages = xmlCollection.pages;
+          outputs[i]->pageCount = xmlCollection.pageCount;
+          outputs[i]->pageOffsets = malloc(sizeof(unsigned long long) * (xmlCollection.pageCount + 1));
+        }
+      }
+
+      if (!writeOutDataFiles(&parserRunTimeData, &xmlCollection)) isWritten = false;
+      if (isIncremental) for (unsigned short i = 0; i < OUTPUTFILES; ++i) finishReusedRows(outputs[i]);
+      for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+        if (!closeOutputBuffer(outputs[i])) {
+          printf("[ ERROR ] Cannot write all rows of \"%s\".\n", outputs[i]->fileName);
+          isWritten = false;
+        }
+      }
+      for (unsigned short i = 0; i < OUTPUTFILES; ++i) reportOutputBuffer(outputs[i]);
+
+      if (isSharded) {
+        writeOutManifest(outputs, &shards, &xmlCollection, parserRunTimeData.currentLine);
+        printf("[REPORT] %d SHARDS LISTED IN %s\n", shards.count, MANIFESTFILE);
+      }
+
+      if (isPageIndexed && writeOutPageIndex(outputs, &xmlCollection)) {
+        printf("[REPORT] %d PAGES INDEXED IN %s\n", xmlCollection.pageCount, PAGEINDEXFILE);
+      }
+
+      if (isIncremental && writeOutRevisionManifest(&incremental, outputs, &xmlCollection)) {
+        printf("[REPORT] %d PAGES, %d COPIED FROM %s, IN %s\n", xmlCollection.pageCount, incremental.reusedCount, PREVIOUSDIRECTORY, REVISIONMANIFESTFILE);
+      }
+
+      for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+        free(outputs[i]->shardBytes);
+        free(outputs[i]->pageOffsets);
+      }
+      freeOutputShards(&shards);
+    }
+
+    if (VOCABULARY && !LINKSONLY && writeOutVocabulary(&vocabulary)) {
+      printf("[REPORT] %d DISTINCT WORDS IN %s\n", vocabulary.count, VOCABULARYFILE);
+    }
+
+    if (VOCABULARY && INVERTEDINDEX && !LINKSONLY && writeOutInvertedIndex(&vocabulary, &xmlCollection)) {
+      printf("[REPORT] %d WORDS WITH POSTINGS IN %s\n", vocabulary.count, INVERTEDINDEXFILE);
+    }
+
+    if (TARGETIDS && !LINKSONLY && writeOutTargets(&targets)) {
+      printf("[REPORT] %d DISTINCT WIKITAG TARGETS IN %s\n", targets.count, TARGETSFILE);
+    }
+
+    if (FORMATSPANS && !LINKSONLY && writeOutFormatSpans(&formatSpans)) {
+      printf("[REPORT] %d FORMAT SPANS IN %s\n", formatSpans.count, FORMATSPANSFILE);
+    }
+
+    if (SECTIONINDEX && !LINKSONLY && writeOutSections(&sections)) {
+      printf("[REPORT] %d SECTIONS IN %s\n", sections.count, SECTIONINDEXFILE);
+    }
+
+    if (TEMPLATEPARAMETERS && !LINKSONLY && writeOutParameters(&parameters, &targets)) {
+      printf("[REPORT] %d TEMPLATE PARAMETERS WITH %d DISTINCT KEYS IN %s\n", parameters.count, parameters.keys.count, PARAMETERSFILE);
+    }
+
+    if (PAGEMETADATA && writeOutMetadata(&metadata, &xmlCollection)) {
+      printf("[REPORT] %d PAGES WITH METADATA IN %s\n", xmlCollection.pageCount, METADATAFILE);
+    }
+
+    if (REVISIONDELTAS && !LINKSONLY && deltas.deltasFile != NULL) {
+      printf("[REPORT] %d REVISIONS IN %s\n", deltas.revisionCount, REVISIONDELTASFILE);
+    }
+
+    if (LINKGRAPH && writeOutLinkGraph(&links, &targets, &xmlCollection)) {
+      printf("[REPORT] %d LINKS OF %d PAGES IN %s\n", links.count, xmlCollection.pageCount, LINKGRAPHFILE);
+    }
+
+    if (outputWriter != NULL) {
+      #if DEBUG || BEVERBOSE
+      printf("[STATUS] WRITE OUT BY %s\n", outputWriter->isRing ? "IO_URING" : "HELPER THREAD");
+      #endif
+      closeAsyncWriter(outputWriter);
+    }
+    if (parserRunTimeData.dictFile != NULL) fclose(parserRunTimeData.dictFile);
+    if (parserRunTimeData.wtagFile != NULL) fclose(parserRunTimeData.wtagFile);
+    if (parserRunTimeData.xmltagFile != NULL) fclose(parserRunTimeData.xmltagFile);
+    if (parserRunTimeData.xmldataFile != NULL) fclose(parserRunTimeData.xmldataFile);
+    if (parserRunTimeData.entitiesFile != NULL) fclose(parserRunTimeData.entitiesFile);
+    if (parserRunTimeData.redirectsFile != NULL) fclose(parserRunTimeData.redirectsFile);
 
     long int duration = difftime(time(NULL), startTime);
     long int durHours = floor(duration / 3600);
     long int durMinutes = floor((duration % 3600) / 60);
     long int durSeconds = (duration % 3600) % 60;
     printf("\n\n[STATUS] SAVING DATA PROCESS: %ldh %ldm %lds\n", durHours, durMinutes, durSeconds);
+    if (!isWritten) printf("[ ERROR ] The write out failed, the output files are incomplete.\n");
   }
 
   //----------------------------------------------------------------------------
   // Cleanup
 
   free(line);
+  free(parserRunTimeData.openWikiTag.data);
+  free(parserRunTimeData.pageTitle);
+  freeNamespaces(&namespaces);
+  freeVocabulary(&vocabulary);
+  freeLinks(&links);
+  freeTargets(&targets);
   freeXMLCollection(&xmlCollection);
-  return 0;
+  freeSharedTags(&sharedTags);
+  freeFormatSpans(&formatSpans);
+  freeSections(&sections);
+  freeParameters(&parameters);
+  freeMetadata(&metadata);
+  freeRevisionDeltas(&deltas);
+  freeIncremental(&incremental);
+  freePageFilters(&filter);
+  return isWritten ? 0 : 1;
 }
 
 //------------------------------------------------------------------------------
@@ -669,6 +1887,13 @@ int parseXMLNode(const unsigned int xmlTagStart, const unsigned int lineLength,
   xmlDataCollection* xmlCollection = parserRunTimeData->xmlCollection;
   collectionStatistics* cData = parserRunTimeData->cData;
 
+  // NOTE: Text data does not contain raw '<', so any xml tag ends open inline spans, wikitags and math sections
+  parserRunTimeData->skipData = false;
+  parserRunTimeData->openInlineSpan = -1;
+  parserRunTimeData->openWikiTag.wikiTagType = -1;
+  parserRunTimeData->openWikiTag.dataLength = 0;
+  parserRunTimeData->isMathSection = false;
+
   xmlNode *xmlTag = NULL;
   if (!isSubCall) {
     xmlCollection->nodes = (xmlNode*) realloc(xmlCollection->nodes, sizeof(xmlNode) * (xmlCollection->count + 1));
@@ -690,6 +1915,11 @@ int parseXMLNode(const unsigned int xmlTagStart, const unsigned int lineLength,
     xmlTag->words = NULL;
     xmlTag->entities = NULL;
     xmlTag->wikiTags = NULL;
+
+    if (SECTIONINDEX && !LINKSONLY) {
+      parserRunTimeData->sections->headingCount = 0;
+      parserRunTimeData->sections->nodeStartByte = parserRunTimeData->inputPosition;
+    }
   } else xmlTag = &xmlCollection->nodes[xmlCollection->count - 1];
 
   // Routine variables
@@ -795,6 +2025,23 @@ int parseXMLNode(const unsigned int xmlTagStart, const unsigned int lineLength,
         openXMLNode->end = parserRunTimeData->currentLine;
         cData->byteXMLsaved += (strlen(openXMLNode->name) * 2) + 3;
 
+        if (FORMATSPANS && !LINKSONLY && (openXMLNode->wordCount != 0 || openXMLNode->entityCount != 0 || openXMLNode->wTagCount != 0)) {
+          addNodeFormatSpans(parserRunTimeData->formatSpans, openXMLNode);
+        }
+
+        if (SECTIONINDEX && !LINKSONLY && xmlCollection->pageCount != 0 && strcmp(openXMLNode->name, "text") == 0) {
+          addNodeSections(parserRunTimeData->sections, openXMLNode, parserRunTimeData);
+        }
+
+        if (REVISIONDELTAS && !LINKSONLY && xmlCollection->pageCount != 0 && strcmp(openXMLNode->name, "text") == 0) {
+          addRevisionDelta(parserRunTimeData->deltas, openXMLNode, parserRunTimeData);
+        }
+
+        if (xmlCollection->pageCount != 0 && strcmp(openXMLNode->name, "page") == 0) {
+          xmlCollection->pages[xmlCollection->pageCount - 1].endLine = parserRunTimeData->currentLine;
+          parserRunTimeData->isPageEnd = true;
+        }
+
         if (i < xmlCollection->openNodeCount) {
           memmove(&xmlCollection->openNodes[i], &xmlCollection->openNodes[i+1], (xmlCollection->openNodeCount-(i+1)) * sizeof(unsigned int));
         }
@@ -827,14 +2074,20 @@ int parseXMLNode(const unsigned int xmlTagStart, const unsigned int lineLength,
       xmlCollection->openNodes = (unsigned int*) realloc(xmlCollection->openNodes, sizeof(unsigned int) * (xmlCollection->openNodeCount + 1));
       xmlCollection->openNodes[xmlCollection->openNodeCount] = xmlCollection->count - 1;
       ++xmlCollection->openNodeCount;
+
+      if (strcmp(xmlTag->name, "page") == 0) addPage(parserRunTimeData);
     }
   }
 
+  // Page and site information read from the data as it is
+  if (!nodeClosed && xmlTag->name != NULL && readerPos < lineLength - 1) readNodeInfo(xmlTag, &line[readerPos], parserRunTimeData);
+
   // Start process the data of the XML tag
   if (!nodeClosed && readerPos < lineLength - 1) {
     //printf("\n## FUNC A ######################################### ---- CL %d\n\n", parserRunTimeData->currentLine);
     xmlTag->isDataNode = true;
-    readerPos += parseXMLData(0, lineLength-readerPos, &line[readerPos], xmlTag, parserRunTimeData);
+    if (parserRunTimeData->skipData) readerPos += strcspn(&line[readerPos], "<");
+    else readerPos += parseXMLData(0, lineLength-readerPos, &line[readerPos], xmlTag, parserRunTimeData);
     if (readerPos < lineLength) parseXMLNode(readerPos, lineLength-readerPos, &line[readerPos], parserRunTimeData, true);
   }
 
@@ -891,14 +2144,82 @@ int parseXMLData(unsigned int readerPos, const unsigned int lineLength, const ch
   unsigned int entityReadPos = 0;
   unsigned int entityWritePos = 0;
 
+  // Inline html span variables
+  short spanType = -1;
+  bool isSpanClosing = false;
+  unsigned int tagEndPos = 0;
+  unsigned int spanEndPos = 0;
+
+  // Wikitag or table still open from a previous line
+  openWikiTagState *openWikiTag = &parserRunTimeData->openWikiTag;
+  char *tagData = NULL;
+  unsigned int tagLine = 0;
+  unsigned int tagPosition = 0;
+
+  if (openWikiTag->wikiTagType != -1) {
+    isWikiTag = true;
+    wikiTagType = openWikiTag->wikiTagType;
+    wikiTagDepth = openWikiTag->wikiTagDepth;
+    mathDeep = openWikiTag->mathDeep;
+    dataFormatType = openWikiTag->dataFormatType;
+    ownFormatType = openWikiTag->ownFormatType;
+    isFormatStart = openWikiTag->isFormatStart;
+    hasPipe = openWikiTag->hasPipe;
+    preSpacesCount = openWikiTag->preSpacesCount;
+  }
 
   while (readerPos < lineLength) {
     readIn = line[readerPos];
 
+    // Raw inline span (comment, nowiki, pre) continued from a previous line
+    if (parserRunTimeData->openInlineSpan != -1 && writerPos == 0 && readIn != '<' && readIn != '\n' && readIn != '\r') {
+      readerPos = readInlineSpan(parserRunTimeData->openInlineSpan, readerPos, readerPos, lineLength, line, readData, &writerPos, parserRunTimeData);
+      createWord = true;
+
+    // Table lines are read as they are and split into rows and cells by addWikiTable
+    } else if (isWikiTag && wikiTagType == TABLETAG && !doCloseWikiTag && readIn != '<' && readIn != '\n' && readIn != '\r') {
+      readerPos = readWikiTable(readerPos, lineLength, line, readData, &writerPos, &wikiTagDepth);
+
+      if (wikiTagDepth != 0) {
+        ++readerPos;
+        continue;
+      }
+
+      cData->byteWikiTags += 2;
+      doCloseWikiTag = true;
+
     // Escape before xml tag closings and such
-    switch (readIn) {
+    } else switch (readIn) {
       case '\n':
       case '\r':
+        /*
+          NOTE: Templates, tables and math are kept open, their data and state
+                continue on the next line. Links end with their line and a blank
+                line ends any open wikitag, both are added as read so far.
+        */
+        if (isWikiTag && !doCloseWikiTag && readerPos != 0 && tagTypes[wikiTagType][0] == '{') {
+          if (openWikiTag->wikiTagType == -1) {
+            openWikiTag->startLine = parserRunTimeData->currentLine;
+            openWikiTag->startPosition = parserRunTimeData->currentPosition;
+            openWikiTag->dataLength = 0;
+          }
+
+          openWikiTag->wikiTagType = wikiTagType;
+          openWikiTag->wikiTagDepth = wikiTagDepth;
+          openWikiTag->mathDeep = mathDeep;
+          openWikiTag->dataFormatType = dataFormatType;
+          openWikiTag->ownFormatType = ownFormatType;
+          openWikiTag->isFormatStart = isFormatStart;
+          openWikiTag->hasPipe = hasPipe;
+          openWikiTag->preSpacesCount = preSpacesCount;
+
+          readData[writerPos++] = '\n';
+          appendWikiTagData(openWikiTag, readData, writerPos);
+          writerPos = 0;
+          ++readerPos;
+          continue;
+        } else if (isWikiTag) doCloseWikiTag = true;
+
         preSpacesCount = 0;
         spacesCount = 0;
         if (writerPos != 0) createWord = true;
@@ -1018,7 +2339,15 @@ int parseXMLData(unsigned int readerPos, const unsigned int lineLength, const ch
         break;
       case '[':
       case '{':
-        if (readIn == '{' && parserRunTimeData->isMathSection && line[readerPos + 1] == readIn) {
+        if (readIn == '{' && readerPos == 0 && !isWikiTag && !parserRunTimeData->isMathSection && line[readerPos + 1] == '|') {
+          // Table start, only valid at the beginning of a line
+          wikiTagType = TABLETAG;
+          wikiTagDepth = 1;
+          isWikiTag = true;
+          cData->byteWikiTags += 2;
+          readerPos += 2;
+          continue;
+        } else if (readIn == '{' && parserRunTimeData->isMathSection && line[readerPos + 1] == readIn) {
           ++wikiTagDepth;
           ++mathDeep;
           readerPos += 2;
@@ -1027,6 +2356,15 @@ int parseXMLData(unsigned int readerPos, const unsigned int lineLength, const ch
           tmpChar = line[readerPos + 1];
 
           if (tmpChar == readIn) {
+            // Nested wikitags are kept as they are and parsed by addWikiTag
+            if (isWikiTag) {
+              ++wikiTagDepth;
+              readData[writerPos++] = readIn;
+              readData[writerPos++] = readIn;
+              readerPos += 2;
+              continue;
+            }
+
             if (writerPos != 0) {
               createWord = true;
               --readerPos;
@@ -1049,33 +2387,17 @@ int parseXMLData(unsigned int readerPos, const unsigned int lineLength, const ch
             formatData[formatDataPos] = '\0';
 
             short tagLength = 0;
-            for (short i = 0; i < TAGTYPES; ++i) {
-              tagLength = strlen(tagTypes[i]);
-              if (strncmp(formatData, tagTypes[i], tagLength) == 0) {
-                if (wikiTagType == MATHTAG) {
-                  parserRunTimeData->isMathSection = true;
-                  cData->byteWikiTags += tagLength;
-                  ++wikiTagDepth;
-                  wikiTagType = i;
-                  readerPos += tagLength - 1;
-                  break;
-                }
-
-                /*if (wikiTagDepth != 0) {
-                  cData->byteWikiTags += tagLength;
-                  ++wikiTagDepth;
-                  readerPos += tagLength - 1;
-                  break;
-                }*/
+            short foundTagType = findWikiTagType(formatData, &line[readerPos], &tagLength, parserRunTimeData->namespaces);
 
-                ++wikiTagDepth;
-                wikiTagType = i;
+            if (foundTagType != -1) {
+              if (wikiTagType == MATHTAG) {
+                parserRunTimeData->isMathSection = true;
+              } else isWikiTag = true;
 
-                isWikiTag = true;
-                cData->byteWikiTags += tagLength;
-                readerPos += tagLength - 1;
-                break;
-              }
+              ++wikiTagDepth;
+              wikiTagType = foundTagType;
+              cData->byteWikiTags += tagLength;
+              readerPos += tagLength - 1;
             }
 
             if (parserRunTimeData->isMathSection) {
@@ -1131,6 +2453,11 @@ int parseXMLData(unsigned int readerPos, const unsigned int lineLength, const ch
               cData->byteWikiTags += 2;
 
               if (!parserRunTimeData->isMathSection && wikiTagDepth != 0) {
+                if (isWikiTag) {
+                  readData[writerPos++] = readIn;
+                  readData[writerPos++] = readIn;
+                }
+
                 readerPos += 2;
                 continue;
               }
@@ -1345,14 +2672,75 @@ int parseXMLData(unsigned int readerPos, const unsigned int lineLength, const ch
 
           entityBuffer[entityWritePos] = '\0';
 
-          if (!parserRunTimeData->isMathSection && line[entityReadPos] == 'm' && entityReadPos + 4 <= lineLength && strcmp(entityBuffer, "&lt;") == 0) {
-            formatDataPos = 0;
-            while (formatDataPos < 5) {
-              formatData[formatDataPos] = tolower(line[entityReadPos + formatDataPos]);
-              ++formatDataPos;
-            }
+          // Escaped inline html spans: &lt;ref&gt;, &lt;nowiki&gt;, &lt;pre&gt; and &lt;!-- --&gt;
+          if (!parserRunTimeData->isMathSection && strcmp(entityBuffer, "&lt;") == 0 && (spanType = findInlineSpan(&line[entityReadPos], lineLength - entityReadPos, &isSpanClosing)) != -1) {
+            spanEndPos = 0;
+            tagEndPos = findSequence(line, entityReadPos, lineLength, "&gt;");
 
-            formatData[formatDataPos - 1] = '\0';
+            if (spanType == 0) {
+              readerPos = readInlineSpan(spanType, readerPos, entityReadPos + 3, lineLength, line, readData, &writerPos, parserRunTimeData);
+              createWord = true;
+            } else if (tagEndPos == 0) {
+              spanType = -1;
+            } else if (isSpanClosing || line[tagEndPos - 5] == '/') {
+              // Unmatched closings and self closing tags are kept as one raw token
+              spanEndPos = tagEndPos;
+              createWord = true;
+            } else if (spanType != REFSPAN) {
+              readerPos = readInlineSpan(spanType, readerPos, tagEndPos, lineLength, line, readData, &writerPos, parserRunTimeData);
+              createWord = true;
+            } else if ((spanEndPos = findSequence(line, tagEndPos, lineLength, inlineSpanClosings[REFSPAN])) != 0 && spanEndPos - 12 > tagEndPos) {
+              // The attributes of the opening become the target, the body is parsed after the '|'
+              formatReaderPos = entityReadPos + 3;
+              while (formatReaderPos < tagEndPos - 4 && line[formatReaderPos] == ' ') ++formatReaderPos;
+
+              writerPos = tagEndPos - 4 - formatReaderPos;
+              while (writerPos != 0 && line[formatReaderPos + writerPos - 1] == ' ') --writerPos;
+
+              memcpy(readData, &line[formatReaderPos], writerPos);
+              readData[writerPos++] = '|';
+              memcpy(&readData[writerPos], &line[tagEndPos], spanEndPos - 12 - tagEndPos);
+              writerPos += spanEndPos - 12 - tagEndPos;
+              cData->byteWikiTags += (tagEndPos - readerPos) + 12;
+              wikiTagType = REFTAG;
+              isWikiTag = true;
+              doCloseWikiTag = true;
+            } else {
+              // Reference spanning lines, keep the opening only as raw token
+              spanEndPos = tagEndPos;
+              createWord = true;
+            }
+
+            if (spanType != -1) {
+              isEntity = false;
+              entityBuffer[0] = '\0';
+
+              if (spanEndPos != 0) {
+                if (!isWikiTag) {
+                  writerPos = spanEndPos - readerPos;
+                  memcpy(readData, &line[readerPos], writerPos);
+                }
+
+                readerPos = spanEndPos - 1;
+              }
+
+              while (line[readerPos + 1] == ' ') {
+                ++spacesCount;
+                ++readerPos;
+              }
+
+              break;
+            }
+          }
+
+          if (!parserRunTimeData->isMathSection && line[entityReadPos] == 'm' && entityReadPos + 4 <= lineLength && strcmp(entityBuffer, "&lt;") == 0) {
+            formatDataPos = 0;
+            while (formatDataPos < 5) {
+              formatData[formatDataPos] = tolower(line[entityReadPos + formatDataPos]);
+              ++formatDataPos;
+            }
+
+            formatData[formatDataPos - 1] = '\0';
 
             // TODO: Think about, if "\begin" and "\end" are found - should this be filtered out and be stored as information to the "words" file? Or should this only be used to avoid creating wikitags?
             if (strcmp(formatData, "math") == 0) {
@@ -1429,16 +2817,28 @@ int parseXMLData(unsigned int readerPos, const unsigned int lineLength, const ch
       createWord = false;
       readData[writerPos] = '\0';
       isAdded = false;
-      if (writerPos != 0 || isEntity) {
+      if (writerPos != 0 || isEntity || (isWikiTag && openWikiTag->wikiTagType != -1)) {
         #if DEBUG
         printf("[DEBUG] LINE: %d | SPACING: %d/%d | WTD: %d | POS: %8d | READER: %8d | DATA: %5d", parserRunTimeData->currentLine, preSpacesCount, spacesCount, doCloseWikiTag ? wikiTagDepth + 1 : wikiTagDepth, parserRunTimeData->currentPosition, readerPos, isEntity ? entityWritePos : writerPos);
         #endif
 
         if (isWikiTag) {
+          tagData = readData;
+
+          // Wikitags opened on a previous line are added with the line and position they started at
+          if (openWikiTag->wikiTagType != -1) {
+            appendWikiTagData(openWikiTag, readData, writerPos);
+            tagData = openWikiTag->data;
+            tagLine = parserRunTimeData->currentLine;
+            tagPosition = parserRunTimeData->currentPosition;
+            parserRunTimeData->currentLine = openWikiTag->startLine;
+            parserRunTimeData->currentPosition = openWikiTag->startPosition;
+          }
+
           #if DEBUG
-          printf(" | WIKITAG | DATA: \"%s\" '%s'", readData, wikiTagNames[wikiTagType]);
+          printf(" | WIKITAG | DATA: \"%s\" '%s'", tagData, wikiTagNames[wikiTagType]);
           #elif BEVERBOSE
-          printf("WIKITAG   | LINE: %8d | %8d | DATA: \"%s\" '%s'", parserRunTimeData->currentLine, parserRunTimeData->currentPosition, readData, wikiTagNames[wikiTagType]);
+          printf("WIKITAG   | LINE: %8d | %8d | DATA: \"%s\" '%s'", parserRunTimeData->currentLine, parserRunTimeData->currentPosition, tagData, wikiTagNames[wikiTagType]);
           #endif
 
           #if DEBUG
@@ -1448,11 +2848,23 @@ int parseXMLData(unsigned int readerPos, const unsigned int lineLength, const ch
           if (isFormatEnd) printf(" < isEnd");
           #endif
 
-          if (addWikiTag(0, xmlTag, dataFormatType, ownFormatType, isFormatStart, isFormatEnd, wikiTagType, preSpacesCount, spacesCount, hasPipe, readData, parserRunTimeData)) {
+          if (wikiTagType == TABLETAG) {
+            if (addWikiTable(0, xmlTag, dataFormatType, ownFormatType, isFormatStart, isFormatEnd, preSpacesCount, spacesCount, hasPipe, tagData, parserRunTimeData)) {
+              isAdded = true;
+              ++cData->wikiTagCount;
+            }
+          } else if (addWikiTag(0, xmlTag, dataFormatType, ownFormatType, isFormatStart, isFormatEnd, wikiTagType, preSpacesCount, spacesCount, hasPipe, tagData, parserRunTimeData)) {
             isAdded = true;
             ++cData->wikiTagCount;
           }
 
+          if (openWikiTag->wikiTagType != -1) {
+            parserRunTimeData->currentLine = tagLine;
+            parserRunTimeData->currentPosition = tagPosition;
+            openWikiTag->wikiTagType = -1;
+            openWikiTag->dataLength = 0;
+          }
+
           hasPipe = false;
           preSpacesCount = 0;
           spacesCount = 0;
@@ -1497,7 +2909,6 @@ int parseXMLData(unsigned int readerPos, const unsigned int lineLength, const ch
           if (isFormatEnd) printf(" < isEnd");
           #endif
 
-          // TODO: Think of "pre" and "/pre" as switch for nonformatting parts
           if (addWord(0, xmlTag,  dataFormatType, ownFormatType, isFormatStart, isFormatEnd, preSpacesCount, spacesCount, hasPipe, readData, parserRunTimeData)) {
             isAdded = true;
             ++cData->wordCount;
@@ -1581,6 +2992,396 @@ int parseXMLData(unsigned int readerPos, const unsigned int lineLength, const ch
 
 //------------------------------------------------------------------------------
 
+/*
+  NOTE: Reads the namespaces of the siteinfo, the title and id of the current
+        page and checks the text of the page for being a redirect.
+*/
+void readNodeInfo(const xmlNode *xmlTag, const char *data, struct parserBaseStore *parserRunTimeData) {
+  xmlDataCollection* xmlCollection = parserRunTimeData->xmlCollection;
+
+  if (strcmp(xmlTag->name, "namespace") == 0) {
+    addSiteNamespace(xmlTag, data, parserRunTimeData->namespaces);
+  } else if (strcmp(xmlTag->name, "title") == 0) {
+    readPageTitle(data, parserRunTimeData);
+  } else if (strcmp(xmlTag->name, "id") == 0 && parserRunTimeData->pageId == 0) {
+    // NOTE: The page id comes ahead of the revision and contributor ids
+    parserRunTimeData->pageId = strtoul(data, NULL, 10);
+    if (xmlCollection->pageCount != 0) xmlCollection->pages[xmlCollection->pageCount - 1].pageId = parserRunTimeData->pageId;
+  } else if (REDIRECTTABLE && strcmp(xmlTag->name, "text") == 0 && addRedirect(data, parserRunTimeData)) {
+    parserRunTimeData->skipData = true;
+  }
+}
+
+void readPageTitle(const char *data, struct parserBaseStore *parserRunTimeData) {
+  xmlDataCollection* xmlCollection = parserRunTimeData->xmlCollection;
+  const unsigned int dataLength = strcspn(data, "<\r\n");
+
+  if (dataLength + 1 > parserRunTimeData->pageTitleBuffer) {
+    parserRunTimeData->pageTitleBuffer = dataLength + 1;
+    parserRunTimeData->pageTitle = (char*) realloc(parserRunTimeData->pageTitle, sizeof(char) * parserRunTimeData->pageTitleBuffer);
+  }
+
+  memcpy(parserRunTimeData->pageTitle, data, dataLength);
+  parserRunTimeData->pageTitle[dataLength] = '\0';
+
+  if (xmlCollection->pageCount != 0 && xmlCollection->pages[xmlCollection->pageCount - 1].title == NULL) {
+    xmlCollection->pages[xmlCollection->pageCount - 1].title = malloc(sizeof(char) * (dataLength + 1));
+    strcpy(xmlCollection->pages[xmlCollection->pageCount - 1].title, parserRunTimeData->pageTitle);
+  }
+}
+
+// NOTE: Starts the page at the current line, the id and title follow
+void addPage(struct parserBaseStore *parserRunTimeData) {
+  xmlDataCollection* xmlCollection = parserRunTimeData->xmlCollection;
+
+  parserRunTimeData->pageId = 0;
+  parserRunTimeData->pageWordCount = 0;
+  if (parserRunTimeData->pageTitle != NULL) parserRunTimeData->pageTitle[0] = '\0';
+
+  xmlCollection->pages = (page*) realloc(xmlCollection->pages, sizeof(page) * (xmlCollection->pageCount + 1));
+  xmlCollection->pages[xmlCollection->pageCount] = (page) {0, parserRunTimeData->currentLine, parserRunTimeData->currentLine, parserRunTimeData->inputPosition, NULL};
+  ++xmlCollection->pageCount;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Adds the page as redirect when its text starts with "#REDIRECT [[target",
+        the rest of the text is skipped then.
+*/
+bool addRedirect(const char *data, struct parserBaseStore *parserRunTimeData) {
+  xmlDataCollection* xmlCollection = parserRunTimeData->xmlCollection;
+  collectionStatistics* cData = parserRunTimeData->cData;
+
+  const char redirectTag[] = "#redirect";
+  unsigned int readerPos = 0;
+  unsigned int targetLength = 0;
+
+  for (readerPos = 0; redirectTag[readerPos] != '\0'; ++readerPos) {
+    if (tolower(data[readerPos]) != redirectTag[readerPos]) return false;
+  }
+
+  while (data[readerPos] == ' ' || data[readerPos] == ':') ++readerPos;
+  if (data[readerPos] != '[' || data[readerPos + 1] != '[') return false;
+
+  readerPos += 2;
+  targetLength = strcspn(&data[readerPos], "]|<\r\n");
+  if (data[readerPos + targetLength] != ']' && data[readerPos + targetLength] != '|') return false;
+
+  xmlCollection->redirects = (redirect*) realloc(xmlCollection->redirects, sizeof(redirect) * (xmlCollection->redirectCount + 1));
+  redirect *pageRedirect = &xmlCollection->redirects[xmlCollection->redirectCount];
+  ++xmlCollection->redirectCount;
+
+  pageRedirect->pageId = parserRunTimeData->pageId;
+  pageRedirect->lineNum = parserRunTimeData->currentLine;
+  pageRedirect->title = malloc(sizeof(char) * (parserRunTimeData->pageTitle == NULL ? 1 : strlen(parserRunTimeData->pageTitle) + 1));
+  strcpy(pageRedirect->title, parserRunTimeData->pageTitle == NULL ? "" : parserRunTimeData->pageTitle);
+  pageRedirect->target = malloc(sizeof(char) * (targetLength + 1));
+  memcpy(pageRedirect->target, &data[readerPos], targetLength);
+  pageRedirect->target[targetLength] = '\0';
+
+  cData->byteRedirects += readerPos + targetLength;
+
+  #if DEBUG || BEVERBOSE
+  printf("[STATUS]  | LINE: %8d | REDIRECT: '%s' > '%s'\n", parserRunTimeData->currentLine, pageRedirect->title, pageRedirect->target);
+  #endif
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: "formatData" holds the lowercase beginning of the wikitag used for the
+        "{{" tag types, "data" the wikitag itself. Links are classified by the
+        namespace prefix in front of the first ':' by a single lookup. Returns
+        the tag type or -1 and sets the length of the tag opening to skip.
+*/
+short findWikiTagType(const char *formatData, const char *data, short *tagLength, const namespaceTable *namespaces) {
+  if (data[0] == '[') {
+    unsigned int prefixLength = strcspn(&data[2], ":|[]{}<\n");
+
+    if (data[prefixLength + 2] == ':' && prefixLength != 0 && prefixLength <= NAMESPACENAMELENGTH) {
+      namespaceEntry *entry = findNamespace(namespaces, &data[2], prefixLength);
+
+      if (entry != NULL && entry->tagType != LINKTAG) {
+        *tagLength = prefixLength + 3;
+        return entry->tagType;
+      }
+    }
+
+    *tagLength = 2;
+    return LINKTAG;
+  }
+
+  for (short i = 0; i < TAGTYPES; ++i) {
+    if (tagTypes[i][0] != '{' || tagTypes[i][1] != '{') continue;
+
+    *tagLength = strlen(tagTypes[i]);
+    if (strncmp(formatData, tagTypes[i], *tagLength) == 0) return i;
+  }
+
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+
+short namespaceTagType(const short key) {
+  for (short i = 0; i < NAMESPACEKEYS; ++i) {
+    if (namespaceKeyTagTypes[i][0] == key) return namespaceKeyTagTypes[i][1];
+  }
+
+  return LINKTAG;
+}
+
+//------------------------------------------------------------------------------
+
+void initNamespaces(namespaceTable *namespaces) {
+  unsigned int nameLength = 0;
+  short key = 0;
+
+  namespaces->size = NAMESPACETABLESIZE;
+  namespaces->count = 0;
+  namespaces->entries = calloc(namespaces->size, sizeof(namespaceEntry));
+
+  // "[[name:" tag types
+  for (short i = 0; i < TAGTYPES; ++i) {
+    nameLength = strlen(tagTypes[i]);
+    if (nameLength < 4 || tagTypes[i][0] != '[' || tagTypes[i][nameLength - 1] != ':') continue;
+
+    key = 0;
+    for (short j = 0; j < NAMESPACETAGTYPES; ++j) {
+      if (namespaceTagTypes[j][1] == i) {
+        key = namespaceTagTypes[j][0];
+        break;
+      }
+    }
+
+    addNamespace(namespaces, &tagTypes[i][2], nameLength - 3, key, i);
+  }
+
+  for (short i = 0; i < NAMESPACEALIASES; ++i) {
+    if (findNamespace(namespaces, namespaceAliases[i], strlen(namespaceAliases[i])) != NULL) continue;
+    addNamespace(namespaces, namespaceAliases[i], strlen(namespaceAliases[i]), namespaceAliasKeys[i], namespaceTagType(namespaceAliasKeys[i]));
+  }
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Names are stored lowercase with underscores as spaces, the same way they
+        are looked up. Open addressing, the table doubles at half its size.
+*/
+void addNamespace(namespaceTable *namespaces, const char *name, const unsigned int nameLength, const short key, const short tagType) {
+  unsigned int hash = 2166136261u;
+  namespaceEntry *entry = NULL;
+
+  if ((namespaces->count + 1) * 2 > namespaces->size) {
+    namespaceTable grownTable = {namespaces->size * 2, 0, NULL};
+    grownTable.entries = calloc(grownTable.size, sizeof(namespaceEntry));
+
+    for (unsigned int i = 0; i < namespaces->size; ++i) {
+      entry = &namespaces->entries[i];
+      if (entry->name == NULL) continue;
+      addNamespace(&grownTable, entry->name, strlen(entry->name), entry->key, entry->tagType);
+      free(entry->name);
+    }
+
+    free(namespaces->entries);
+    *namespaces = grownTable;
+  }
+
+  char *normalizedName = malloc(sizeof(char) * (nameLength + 1));
+  for (unsigned int i = 0; i < nameLength; ++i) {
+    normalizedName[i] = name[i] == '_' ? ' ' : tolower(name[i]);
+    hash = (hash ^ (unsigned char) normalizedName[i]) * 16777619u;
+  }
+
+  normalizedName[nameLength] = '\0';
+
+  entry = &namespaces->entries[hash & (namespaces->size - 1)];
+  while (entry->name != NULL) {
+    if (++entry == &namespaces->entries[namespaces->size]) entry = namespaces->entries;
+  }
+
+  entry->name = normalizedName;
+  entry->key = key;
+  entry->tagType = tagType;
+  ++namespaces->count;
+
+  #if DEBUG
+  printf("[DEBUG] NAMESPACE ADDED: '%s' | KEY: %d | TAGTYPE: '%s'\n", normalizedName, key, wikiTagNames[tagType]);
+  #endif
+}
+
+//------------------------------------------------------------------------------
+
+namespaceEntry* findNamespace(const namespaceTable *namespaces, const char *name, const unsigned int nameLength) {
+  unsigned int hash = 2166136261u;
+  char normalizedName[nameLength];
+
+  for (unsigned int i = 0; i < nameLength; ++i) {
+    normalizedName[i] = name[i] == '_' ? ' ' : tolower(name[i]);
+    hash = (hash ^ (unsigned char) normalizedName[i]) * 16777619u;
+  }
+
+  namespaceEntry *entry = &namespaces->entries[hash & (namespaces->size - 1)];
+  while (entry->name != NULL) {
+    if (strncmp(entry->name, normalizedName, nameLength) == 0 && entry->name[nameLength] == '\0') return entry;
+    if (++entry == &namespaces->entries[namespaces->size]) entry = namespaces->entries;
+  }
+
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Adds the namespace of a <namespace key="14">Category</namespace> node,
+        known names keep their tag type.
+*/
+void addSiteNamespace(const xmlNode *xmlTag, const char *data, namespaceTable *namespaces) {
+  unsigned int nameLength = strcspn(data, "<\r\n");
+  bool hasKey = false;
+  short key = 0;
+
+  for (unsigned int i = 0; i < xmlTag->keyValuePairs; ++i) {
+    if (strcmp(xmlTag->keyValues[i].key, "key") == 0 && xmlTag->keyValues[i].value != NULL) {
+      key = atoi(xmlTag->keyValues[i].value);
+      hasKey = true;
+    }
+  }
+
+  if (!hasKey || nameLength == 0 || nameLength > NAMESPACENAMELENGTH) return;
+  if (findNamespace(namespaces, data, nameLength) != NULL) return;
+
+  addNamespace(namespaces, data, nameLength, key, namespaceTagType(key));
+}
+
+//------------------------------------------------------------------------------
+
+void freeNamespaces(namespaceTable *namespaces) {
+  for (unsigned int i = 0; i < namespaces->size; ++i) free(namespaces->entries[i].name);
+  free(namespaces->entries);
+  namespaces->entries = NULL;
+  namespaces->count = 0;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Reads a table line as it is into readData. The closing "|}" and the "{|"
+        of nested tables only count at the beginning of a line. Returns the last
+        read index.
+*/
+unsigned int readWikiTable(const unsigned int readerPos, const unsigned int lineLength, const char *line, char *readData, unsigned int *writerPos, unsigned short *tableDepth) {
+  unsigned int lineEnd = readerPos + strcspn(&line[readerPos], "<\r\n");
+  if (lineEnd > lineLength) lineEnd = lineLength;
+
+  if (readerPos == 0 && line[0] == '|' && line[1] == '}') {
+    --*tableDepth;
+    if (*tableDepth == 0) return 1;
+  } else if (readerPos == 0 && line[0] == '{' && line[1] == '|') ++*tableDepth;
+
+  memcpy(&readData[*writerPos], &line[readerPos], lineEnd - readerPos);
+  *writerPos += lineEnd - readerPos;
+
+  return lineEnd - 1;
+}
+
+//------------------------------------------------------------------------------
+
+void appendWikiTagData(openWikiTagState *openWikiTag, const char *data, const unsigned int dataLength) {
+  if (openWikiTag->dataLength + dataLength + 1 > openWikiTag->dataBuffer) {
+    openWikiTag->dataBuffer = openWikiTag->dataLength + dataLength + LINEBUFFERBASE;
+    openWikiTag->data = (char*) realloc(openWikiTag->data, sizeof(char) * openWikiTag->dataBuffer);
+  }
+
+  memcpy(&openWikiTag->data[openWikiTag->dataLength], data, dataLength);
+  openWikiTag->dataLength += dataLength;
+  openWikiTag->data[openWikiTag->dataLength] = '\0';
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: "data" starts right after an escaped "&lt;". Returns the index of the
+        inline span in inlineSpanNames or -1, isClosing is set for "&lt;/name&gt;".
+*/
+short findInlineSpan(const char *data, const unsigned int dataLength, bool *isClosing) {
+  unsigned int readerPos = 0;
+  unsigned int nameLength = 0;
+  unsigned int i = 0;
+  char tmpChar = '\0';
+
+  *isClosing = false;
+  if (dataLength != 0 && data[0] == '/') {
+    *isClosing = true;
+    readerPos = 1;
+  }
+
+  for (short spanType = 0; spanType < INLINESPANS; ++spanType) {
+    nameLength = strlen(inlineSpanNames[spanType]);
+    if (readerPos + nameLength >= dataLength) continue;
+
+    for (i = 0; i < nameLength; ++i) {
+      if (tolower(data[readerPos + i]) != inlineSpanNames[spanType][i]) break;
+    }
+
+    if (i != nameLength) continue;
+    if (spanType == 0) return *isClosing ? -1 : 0;
+
+    tmpChar = data[readerPos + nameLength];
+    if (tmpChar == '&' || (!*isClosing && (tmpChar == ' ' || tmpChar == '/'))) return spanType;
+  }
+
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Returns the index after "sequence" when found from searchPos on, before
+        the end of the line data and before any xml tag, otherwise 0.
+*/
+unsigned int findSequence(const char *line, const unsigned int searchPos, const unsigned int lineLength, const char *sequence) {
+  const char *found = strstr(&line[searchPos], sequence);
+  if (found == NULL) return 0;
+
+  unsigned int sequenceEnd = (found - line) + strlen(sequence);
+  if (sequenceEnd > lineLength || memchr(&line[searchPos], '<', found - &line[searchPos]) != NULL) return 0;
+
+  return sequenceEnd;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Copies a raw inline span from readerPos up to its closing into readData.
+        When the closing is not on this line, the span is read up to the line or
+        xml tag end and stays open for the following line. Returns the last read index.
+*/
+unsigned int readInlineSpan(const short spanType, const unsigned int readerPos, const unsigned int searchPos, const unsigned int lineLength, const char *line, char *readData, unsigned int *writerPos, struct parserBaseStore *parserRunTimeData) {
+  unsigned int spanEnd = findSequence(line, searchPos, lineLength, inlineSpanClosings[spanType]);
+
+  if (spanEnd == 0) {
+    spanEnd = readerPos + strcspn(&line[readerPos], "<\r\n");
+    if (spanEnd > lineLength) spanEnd = lineLength;
+    parserRunTimeData->openInlineSpan = spanType;
+  } else parserRunTimeData->openInlineSpan = -1;
+
+  #if DEBUG
+  printf("[DEBUG] LINE: %d | READER: %d => INLINE SPAN '%s'%s\n", parserRunTimeData->currentLine, readerPos, inlineSpanNames[spanType], parserRunTimeData->openInlineSpan == -1 ? "" : " CONTINUES");
+  #endif
+
+  memcpy(&readData[*writerPos], &line[readerPos], spanEnd - readerPos);
+  *writerPos += spanEnd - readerPos;
+
+  return spanEnd - 1;
+}
+
+//------------------------------------------------------------------------------
+
 
 bool addWikiTag(const short elementType, void *element, const short dataFormatType, const short ownFormatType, const bool isFormatStart, const bool isFormatEnd, const short wikiTagType, const unsigned char preSpacesCount, const unsigned char spacesCount, const bool wikiTaghasPipe, const char *readData, struct parserBaseStore *parserRunTimeData) {
 
@@ -1616,11 +3417,12 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
   tag->wTagCount = 0;
   tag->entityCount = 0;
   tag->tagLength = dataLength;
-  tag->target = NULL;
+  tag->target = 0;
   tag->wikiTagFileIndex = cData->wikiTagCount;
   tag->pipedWords = NULL;
   tag->pipedTags = NULL;
   tag->pipedEntities = NULL;
+  tag->shared = NULL;
   tag->hasPipe = wikiTaghasPipe;
 
   if (elementType == 0) {
@@ -1636,10 +3438,10 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
   unsigned int writerPos = 0;
 
   char readIn = '\0';
-  char parserData[dataLength];
+  char *parserData = malloc(sizeof(char) * (dataLength + 1));
 
   unsigned int targetWritePos = 0;
-  char targetData[dataLength];
+  char *targetData = malloc(sizeof(char) * (dataLength + 1));
   targetData[0] = '\0';
   bool hasTargetData = false;
 
@@ -1682,6 +3484,23 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
     switch (readIn) {
       case '\n':
       case '\r':
+        // Line breaks of wikitags spanning lines separate words like spaces
+        if (parserRunTimeData->isMathSection || wasMathSection) {
+          parserData[writerPos] = ' ';
+          ++writerPos;
+          ++readerPos;
+          continue;
+        } else if (!hasTargetData) {
+          targetData[targetWritePos++] = ' ';
+          ++readerPos;
+          continue;
+        } else if (isWikiTag) {
+          parserData[writerPos] = ' ';
+          ++writerPos;
+          ++readerPos;
+          continue;
+        }
+
         preSpacesCountInternal = 0;
         spacesCountInternal = 0;
         if (writerPos != 0) createWord = true;
@@ -1708,8 +3527,17 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
           parserData[writerPos] = readIn;
           ++writerPos;
           continue;
-        } else if (tag->target == NULL && !hasTargetData) targetData[targetWritePos++] = readData[readerPos];
-        else if (wikiTagDepth != 0) {
+        } else if (!hasTargetData) targetData[targetWritePos++] = readData[readerPos];
+        else if (isWikiTag) {
+          // Spaces are part of the nested wikitag data
+          while (readData[readerPos] == ' ') {
+            parserData[writerPos] = ' ';
+            ++writerPos;
+            ++readerPos;
+          }
+
+          continue;
+        } else if (wikiTagDepth != 0) {
           while (readData[readerPos] == ' ') {
             if (writerPos == 0) ++preSpacesCountInternal;
             else ++spacesCountInternal;
@@ -1766,7 +3594,7 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
         }
 
         if (formatDataPos == 1) {
-          if (tag->target == NULL && !hasTargetData) targetData[targetWritePos++] = readIn;
+          if (!hasTargetData) targetData[targetWritePos++] = readIn;
           parserData[writerPos] = readData[readerPos];
           ++writerPos;
           break;
@@ -1813,16 +3641,16 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
         formatData[0] = '\0';
         break;
       case '|':
-        if (tag->target == NULL && !hasTargetData) {
+        if (!hasTargetData) {
           hasTargetData = true;
 
-          if (targetWritePos == 0) targetData[targetWritePos++] = '|';
+          // References and table elements without attributes keep an empty target
+          if (targetWritePos == 0 && wikiTagType < REFTAG) targetData[targetWritePos++] = '|';
 
           targetData[targetWritePos] = '\0';
-          tag->target = malloc(sizeof(char) * (targetWritePos + 1));
-          strcpy(tag->target, targetData);
+          tag->target = internTarget(parserRunTimeData->targets, targetData, wikiTagType);
           if (targetWritePos > 1) tag->hasPipe = true;
-          cData->byteWikiTags += targetWritePos - 1;
+          if (targetWritePos != 0 && wikiTagType != REFTAG) cData->byteWikiTags += targetWritePos - 1;
 
           #if DEBUG
           printf("[DEBUG] LINE: %d - TARGET            => \"%s\"\n", parserRunTimeData->currentLine, targetData);
@@ -1833,6 +3661,13 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
           break;
         }
 
+        // Pipes of a nested wikitag are part of its data
+        if (isWikiTag) {
+          parserData[writerPos] = readIn;
+          ++writerPos;
+          ++readerPos;
+          continue;
+        }
 
         if (writerPos != 0) {
           if (ownFormatType != -1) doCloseOwnFormat = true;
@@ -1862,6 +3697,54 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
           tmpChar = readData[readerPos + 1];
 
           if (tmpChar == readIn) {
+            // Templates in the body of a reference become wikitags of the reference
+            if (tmpChar == '{' && wikiTagType == REFTAG && hasTargetData && !isWikiTag && wikiTagDepth == 0) {
+              formatReaderPos = readerPos;
+              formatDataPos = 0;
+
+              while (formatDataPos < 22 && readData[formatReaderPos] != '\0' && readData[formatReaderPos] != ' ' && readData[formatReaderPos] != '|') {
+                formatData[formatDataPos++] = tolower(readData[formatReaderPos++]);
+              }
+
+              formatData[formatDataPos] = '\0';
+
+              short tagLength = 0;
+              if (findWikiTagType(formatData, &readData[readerPos], &tagLength, parserRunTimeData->namespaces) == 1) {
+                unsigned short templateDepth = 1;
+                formatReaderPos = readerPos + 2;
+
+                while (readData[formatReaderPos] != '\0') {
+                  if (readData[formatReaderPos] == '{' && readData[formatReaderPos + 1] == '{') {
+                    ++templateDepth;
+                    ++formatReaderPos;
+                  } else if (readData[formatReaderPos] == '}' && readData[formatReaderPos + 1] == '}') {
+                    if (--templateDepth == 0) break;
+                    ++formatReaderPos;
+                  }
+
+                  ++formatReaderPos;
+                }
+
+                if (templateDepth == 0 && formatReaderPos > readerPos + 2) {
+                  if (writerPos != 0) {
+                    createWord = true;
+                    --readerPos;
+                    break;
+                  }
+
+                  writerPos = formatReaderPos - readerPos - 2;
+                  memcpy(parserData, &readData[readerPos + 2], writerPos);
+                  cData->byteWikiTags += 4;
+
+                  tagType = 1;
+                  isWikiTag = true;
+                  doCloseWikiTag = true;
+                  readerPos = formatReaderPos + 1;
+                  break;
+                }
+              }
+            }
+
             if (tmpChar == '{') {
               ++wikiTagDepth;
               readerPos += 2;
@@ -1891,16 +3774,11 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
             formatData[formatDataPos] = '\0';
 
             short tagLength = 0;
-            for (short i = 0; i < TAGTYPES; ++i) {
-              tagLength = strlen(tagTypes[i]);
-              if (strncmp(formatData, tagTypes[i], tagLength) == 0) {
-                tagType = i;
-                isWikiTag = true;
-                readerPos += tagLength - 1;
-                cData->byteWikiTags += tagLength - 1;
-                ++wikiTagDepth;
-                break;
-              }
+            if ((tagType = findWikiTagType(formatData, &readData[readerPos], &tagLength, parserRunTimeData->namespaces)) != -1) {
+              isWikiTag = true;
+              readerPos += tagLength - 1;
+              cData->byteWikiTags += tagLength - 1;
+              ++wikiTagDepth;
             }
 
             if (isWikiTag) break;
@@ -1908,7 +3786,7 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
         }
 
         parserData[writerPos] = readIn;
-        if (tag->target == NULL && !hasTargetData) targetData[targetWritePos++] = readData[readerPos];
+        if (!hasTargetData) targetData[targetWritePos++] = readData[readerPos];
         ++writerPos;
         ++readerPos;
         continue;
@@ -1996,7 +3874,7 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
           }
         }
 
-        if (tag->target == NULL && !hasTargetData) targetData[targetWritePos++] = readIn;
+        if (!hasTargetData) targetData[targetWritePos++] = readIn;
         parserData[writerPos] = readIn;
         ++writerPos;
         ++readerPos;
@@ -2040,8 +3918,10 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
             continue;
           }
         } else {
+          // Entities of the target are kept as they are
+          isEntity = false;
           parserData[writerPos] = readIn;
-          if (tag->target == NULL && !hasTargetData) targetData[targetWritePos++] = readIn;
+          if (!hasTargetData) targetData[targetWritePos++] = readIn;
           ++writerPos;
           ++readerPos;
           continue;
@@ -2050,7 +3930,7 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
         break;
       default:
         parserData[writerPos] = readData[readerPos];
-        if (tag->target == NULL && !hasTargetData) targetData[targetWritePos++] = readData[readerPos];
+        if (!hasTargetData) targetData[targetWritePos++] = readData[readerPos];
         ++writerPos;
         ++readerPos;
         continue;
@@ -2156,6 +4036,7 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
       createWord = false;
     }
 
+    if (readIn == '\n') ++parserRunTimeData->currentLine;
     ++readerPos;
   }
 
@@ -2164,24 +4045,210 @@ bool addWikiTag(const short elementType, void *element, const short dataFormatTy
   #endif
 
 
-  if (tag->target == NULL && !hasTargetData) {
+  if (!hasTargetData) {
     targetData[targetWritePos] = '\0';
-    tag->target = malloc(sizeof(char) * (targetWritePos + 1));
+    tag->target = internTarget(parserRunTimeData->targets, targetData, wikiTagType);
     tag->hasPipe = hasPipe;
-    strcpy(tag->target, targetData);
     cData->byteWikiTags += targetWritePos;
   }
 
+  if (LINKGRAPH && wikiTagType == 12) addLink(parserRunTimeData->links, parserRunTimeData->xmlCollection->pageCount, tag->target);
+  if (TEMPLATEPARAMETERS && !LINKSONLY && wikiTagType == 1) addTemplateParameters(parserRunTimeData->parameters, tag, readData, parserRunTimeData->pageId);
+
+  // NOTE: Tables get their rows after this, so they are never shared
+  if (SHARETAGS && wikiTagType != 2 && wikiTagType < 14) shareWikiTag(parserRunTimeData->sharedTags, tag);
+
   // 0 WORD, 1 WIKITAG, 2 ENTITY
 
+  free(parserData);
+  free(targetData);
+
  return true;
 }
 
 //------------------------------------------------------------------------------
 
+/*
+  NOTE: Tables become a wikitag holding one "Table row" wikitag per row, which holds
+        the "Table cell" and "Table header" wikitags. Captions are added to the table
+        itself. Nested tables stay part of the content of their cell.
+*/
+bool addWikiTable(const short elementType, void *element, const short dataFormatType, const short ownFormatType, const bool isFormatStart, const bool isFormatEnd, const unsigned char preSpacesCount, const unsigned char spacesCount, const bool hasPipe, const char *readData, struct parserBaseStore *parserRunTimeData) {
 
-bool addEntity(const short elementType, void *element, const short dataFormatType, const short ownFormatType, const bool isFormatStart, const bool isFormatEnd, const unsigned char preSpacesCount, const unsigned char spacesCount, const bool hasPipe, const char* entityBuffer, struct parserBaseStore* parserRunTimeData) {
-  entity *tagEntity = NULL;
+  collectionStatistics* cData = parserRunTimeData->cData;
+
+  wikiTag *table = NULL;
+  wikiTag *row = NULL;
+
+  unsigned int dataLength = strlen(readData);
+  unsigned int lineEnd = strcspn(readData, "\n");
+  unsigned int readerPos = 0;
+  unsigned int separatorPos = 0;
+  unsigned int lineNum = parserRunTimeData->currentLine;
+  unsigned int nestedTables = 0;
+
+  char *cellData = malloc(sizeof(char) * (dataLength + 1));
+  unsigned int cellLength = 0;
+  unsigned int cellLine = 0;
+  short cellType = -1;
+
+  // Table attributes follow the "{|"
+  memcpy(cellData, readData, lineEnd);
+  cellData[lineEnd] = '\0';
+
+  if (!addWikiTag(elementType, element, dataFormatType, ownFormatType, isFormatStart, isFormatEnd, TABLETAG, preSpacesCount, spacesCount, hasPipe, cellData, parserRunTimeData)) {
+    free(cellData);
+    return false;
+  }
+
+  if (elementType == 0) table = &((xmlNode*) element)->wikiTags[((xmlNode*) element)->wTagCount - 1];
+  else table = &((wikiTag*) element)->pipedTags[((wikiTag*) element)->wTagCount - 1];
+
+  readerPos = lineEnd;
+  while (readData[readerPos] == '\n') {
+    ++readerPos;
+    ++lineNum;
+    lineEnd = readerPos + strcspn(&readData[readerPos], "\n");
+
+    if (readData[readerPos] == '{' && readData[readerPos + 1] == '|') ++nestedTables;
+    else if (nestedTables != 0 && readData[readerPos] == '|' && readData[readerPos + 1] == '}') --nestedTables;
+    else if (nestedTables == 0 && (readData[readerPos] == '|' || readData[readerPos] == '!')) {
+      if (cellType != -1) row = addTableCell(table, row, cellType, cellData, cellLength, cellLine, parserRunTimeData);
+
+      cellType = -1;
+      cellLength = 0;
+
+      if (readData[readerPos] == '|' && readData[readerPos + 1] == '-') {
+        // Row attributes follow the "|-"
+        cellLength = lineEnd - readerPos - 2;
+        memcpy(cellData, &readData[readerPos + 2], cellLength);
+        cellData[cellLength] = '\0';
+        cellLength = 0;
+
+        parserRunTimeData->currentLine = lineNum;
+        if (addWikiTag(1, table, -1, -1, false, false, TABLEROWTAG, 0, 0, false, cellData, parserRunTimeData)) ++cData->wikiTagCount;
+        cData->byteWikiTags += 2;
+
+        row = &table->pipedTags[table->wTagCount - 1];
+        readerPos = lineEnd;
+        continue;
+      }
+
+      if (readData[readerPos] == '|' && readData[readerPos + 1] == '+') {
+        cellType = TABLECAPTIONTAG;
+        readerPos += 2;
+      } else {
+        cellType = readData[readerPos] == '!' ? TABLEHEADERTAG : TABLECELLTAG;
+        ++readerPos;
+      }
+
+      cellLine = lineNum;
+
+      // Further cells on the same line are seperated by "||", header cells by "!!" as well
+      while (true) {
+        separatorPos = findTableSeparator(readData, readerPos, lineEnd, "||");
+        if (cellType == TABLEHEADERTAG) {
+          unsigned int headerSeparatorPos = findTableSeparator(readData, readerPos, separatorPos, "!!");
+          if (headerSeparatorPos < separatorPos) separatorPos = headerSeparatorPos;
+        }
+
+        if (separatorPos == lineEnd) break;
+
+        row = addTableCell(table, row, cellType, &readData[readerPos], separatorPos - readerPos, cellLine, parserRunTimeData);
+        cData->byteWikiTags += 2;
+        readerPos = separatorPos + 2;
+      }
+
+      // The last cell of the line may continue on the following lines
+      cellLength = lineEnd - readerPos;
+      memcpy(cellData, &readData[readerPos], cellLength);
+      readerPos = lineEnd;
+      continue;
+    }
+
+    // Content which does not start a new cell belongs to the pending one
+    if (cellType == -1) {
+      cellType = TABLECELLTAG;
+      cellLine = lineNum;
+    } else cellData[cellLength++] = '\n';
+
+    memcpy(&cellData[cellLength], &readData[readerPos], lineEnd - readerPos);
+    cellLength += lineEnd - readerPos;
+    readerPos = lineEnd;
+  }
+
+  if (cellType != -1) addTableCell(table, row, cellType, cellData, cellLength, cellLine, parserRunTimeData);
+
+  free(cellData);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Returns the index of "separator" outside of nested wikitags between
+        readerPos and dataEnd, otherwise dataEnd.
+*/
+unsigned int findTableSeparator(const char *data, unsigned int readerPos, const unsigned int dataEnd, const char *separator) {
+  unsigned int separatorLength = strlen(separator);
+  unsigned short wikiTagDepth = 0;
+
+  for (; readerPos + separatorLength <= dataEnd; ++readerPos) {
+    if ((data[readerPos] == '[' || data[readerPos] == '{') && data[readerPos + 1] == data[readerPos]) {
+      ++wikiTagDepth;
+      ++readerPos;
+    } else if (wikiTagDepth != 0 && (data[readerPos] == ']' || data[readerPos] == '}') && data[readerPos + 1] == data[readerPos]) {
+      --wikiTagDepth;
+      ++readerPos;
+    } else if (wikiTagDepth == 0 && strncmp(&data[readerPos], separator, separatorLength) == 0) return readerPos;
+  }
+
+  return dataEnd;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Adds a cell to the row, or a caption to the table, as "attributes|content".
+        Cells ahead of the first "|-" get an implicit row. Returns the row for
+        the next cells, as adding a caption moves the rows of the table.
+*/
+wikiTag* addTableCell(wikiTag *table, wikiTag *row, const short cellType, const char *cellData, const unsigned int cellLength, const unsigned int cellLine, struct parserBaseStore *parserRunTimeData) {
+
+  collectionStatistics* cData = parserRunTimeData->cData;
+
+  char *parserData = malloc(sizeof(char) * (cellLength + 2));
+  unsigned int writerPos = 0;
+  wikiTag *parentTag = row;
+
+  parserRunTimeData->currentLine = cellLine;
+
+  if (cellType == TABLECAPTIONTAG) parentTag = table;
+  else if (row == NULL) {
+    if (addWikiTag(1, table, -1, -1, false, false, TABLEROWTAG, 0, 0, false, "", parserRunTimeData)) ++cData->wikiTagCount;
+    parentTag = row = &table->pipedTags[table->wTagCount - 1];
+  }
+
+  if (findTableSeparator(cellData, 0, cellLength, "|") == cellLength) parserData[writerPos++] = '|';
+
+  memcpy(&parserData[writerPos], cellData, cellLength);
+  writerPos += cellLength;
+  parserData[writerPos] = '\0';
+
+  if (addWikiTag(1, parentTag, -1, -1, false, false, cellType, 0, 0, false, parserData, parserRunTimeData)) ++cData->wikiTagCount;
+  ++cData->byteWikiTags;
+
+  free(parserData);
+  return cellType == TABLECAPTIONTAG ? NULL : row;
+}
+
+//------------------------------------------------------------------------------
+
+
+bool addEntity(const short elementType, void *element, const short dataFormatType, const short ownFormatType, const bool isFormatStart, const bool isFormatEnd, const unsigned char preSpacesCount, const unsigned char spacesCount, const bool hasPipe, const char* entityBuffer, struct parserBaseStore* parserRunTimeData) {
+  if (LINKSONLY) return true;
+
+  entity *tagEntity = NULL;
   xmlNode *xmlTag = NULL;
   wikiTag *tag = NULL;
 
@@ -2218,7 +4285,66 @@ bool addEntity(const short elementType, void *element, const short dataFormatTyp
 //------------------------------------------------------------------------------
 
 
+/*
+  NOTE: With SPLITPUNCTUATION leading and trailing punctuation of a word is added
+        as words of its own, so "(see" becomes "(" and "see". Only the first
+        part keeps the prespaces and the last part the spaces, the pipe and
+        the format end, so the text can be put back together as it was.
+*/
 bool addWord(const short elementType, void *element, const short dataFormatType, const short ownFormatType, const bool isFormatStart, const bool isFormatEnd, const unsigned char preSpacesCount, const unsigned char spacesCount, const bool hasPipe, const char *readData, struct parserBaseStore* parserRunTimeData) {
+  // NOTE: Words are not kept when only the links are collected
+  if (LINKSONLY) return true;
+
+  #if SPLITPUNCTUATION
+  const unsigned int dataLength = strlen(readData);
+  unsigned int wordStart = 0;
+  unsigned int wordEnd = dataLength;
+  unsigned int lastChar = 0;
+  unsigned int readerPos = 0;
+  unsigned int splitLength = 0;
+  unsigned short charLength = 0;
+  bool isFirst = false;
+  bool isLast = false;
+
+  while (wordStart < wordEnd && (charLength = punctuationLength(&readData[wordStart], wordEnd - wordStart)) != 0) wordStart += charLength;
+
+  while (wordEnd > wordStart) {
+    lastChar = wordEnd - 1;
+    while (lastChar > wordStart && (readData[lastChar] & 0xC0) == 0x80) --lastChar;
+    if (punctuationLength(&readData[lastChar], wordEnd - lastChar) != wordEnd - lastChar) break;
+    wordEnd = lastChar;
+  }
+
+  // NOTE: Words made of punctuation only, like "-" or "...", stay as they are
+  if (wordStart == wordEnd || (wordStart == 0 && wordEnd == dataLength)) return addWordData(elementType, element, dataFormatType, ownFormatType, isFormatStart, isFormatEnd, preSpacesCount, spacesCount, hasPipe, readData, parserRunTimeData);
+
+  char splitData[dataLength + 1];
+
+  while (readerPos < dataLength) {
+    if (readerPos == wordStart) splitLength = wordEnd - wordStart;
+    else splitLength = punctuationLength(&readData[readerPos], dataLength - readerPos);
+
+    memcpy(splitData, &readData[readerPos], splitLength);
+    splitData[splitLength] = '\0';
+
+    isFirst = readerPos == 0;
+    isLast = readerPos + splitLength == dataLength;
+    addWordData(elementType, element, dataFormatType, ownFormatType, isFormatStart && isFirst, isFormatEnd && isLast, isFirst ? preSpacesCount : 0, isLast ? spacesCount : 0, hasPipe && isLast, splitData, parserRunTimeData);
+
+    // NOTE: The caller counts the word once
+    if (!isFirst) ++parserRunTimeData->cData->wordCount;
+    readerPos += splitLength;
+  }
+
+  return true;
+  #else
+  return addWordData(elementType, element, dataFormatType, ownFormatType, isFormatStart, isFormatEnd, preSpacesCount, spacesCount, hasPipe, readData, parserRunTimeData);
+  #endif
+}
+
+//------------------------------------------------------------------------------
+
+bool addWordData(const short elementType, void *element, const short dataFormatType, const short ownFormatType, const bool isFormatStart, const bool isFormatEnd, const unsigned char preSpacesCount, const unsigned char spacesCount, const bool hasPipe, const char *readData, struct parserBaseStore* parserRunTimeData) {
   word *tagWord = NULL;
   xmlNode *xmlTag = NULL;
   wikiTag *tag = NULL;
@@ -2245,6 +4371,12 @@ bool addWord(const short elementType, void *element, const short dataFormatType,
   tagWord->data = malloc(sizeof(char) * (strlen(readData) + 1));
   strcpy(tagWord->data, readData);
 
+  if (VOCABULARY) {
+    vocabularyEntry *entry = addVocabularyWord(parserRunTimeData->vocabulary, tagWord->data);
+    // NOTE: The title comes ahead of the page id, so the postings hold the page count until the write out
+    if (INVERTEDINDEX) addPosting(entry, parserRunTimeData->xmlCollection->pageCount, parserRunTimeData->pageWordCount++);
+  }
+
   if (elementType == 0) {
     ++xmlTag->wordCount;
     if (xmlTag->firstAddedType == -1) xmlTag->firstAddedType = 0;
@@ -2255,185 +4387,4200 @@ bool addWord(const short elementType, void *element, const short dataFormatType,
 }
 
 //------------------------------------------------------------------------------
-bool writeOutDataFiles(const struct parserBaseStore* parserRunTimeData, struct xmlDataCollection* xmlCollection) {
-  struct xmlNode *xmlTag = NULL;
-  struct wikiTag *wTag = NULL;
-  struct word* wordElement = NULL;
-  struct entity* entityElement = NULL;
 
-  #if STRAIGHTWRITEOUT
-    for (unsigned int i = 0; i < xmlCollection->count; ++i) {
-      xmlTag = &xmlCollection->nodes[i];
-      fprintf(parserRunTimeData->xmltagFile, "%d\t%d\t%d\t%d\t%s\n", xmlTag->start , xmlTag->end, xmlTag->isClosed, xmlTag->isDataNode, xmlTag->name);
+void initVocabulary(vocabularyTable *vocabulary) {
+  vocabulary->size = VOCABULARYTABLESIZE;
+  vocabulary->count = 0;
+  vocabulary->entries = calloc(vocabulary->size, sizeof(vocabularyEntry));
+}
 
-      for (unsigned int j = 0; j < xmlTag->keyValuePairs; ++j) {
-        fprintf(parserRunTimeData->xmldataFile, "%d\t%d\t%s\t%s\n", xmlTag->start, xmlTag->end, xmlTag->keyValues[j].key, xmlTag->keyValues[j].value);
-      }
+static inline unsigned int hashWord(const char *data) {
+  unsigned int hash = 2166136261u;
 
-      for (unsigned int j = 0; j < xmlTag->wordCount; ++j) {
-        wordElement = &xmlTag->words[j];
-        fprintf(parserRunTimeData->dictFile, "%u\t%u\t%d\t%d\t%d\t%ld\t%d\t%d\t%d\t%d\t%d\t%s\n", wordElement->position, wordElement->lineNum, -1, wordElement->preSpacesCount, wordElement->spacesCount, strlen(wordElement->data), wordElement->dataFormatType, wordElement->ownFormatType, wordElement->formatStart, wordElement->formatEnd, wordElement->hasPipe, wordElement->data);
-      }
+  for (const unsigned char *readerPos = (const unsigned char*) data; *readerPos != '\0'; ++readerPos) {
+    hash ^= *readerPos;
+    hash *= 16777619u;
+  }
 
-      for (unsigned int j = 0; j < xmlTag->entityCount; ++j) {
-        entityElement = &xmlTag->entities[j];
-        fprintf(parserRunTimeData->entitiesFile, "%u\t%u\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%s\n",  entityElement->position, entityElement->lineNum, -1, entityElement->preSpacesCount, entityElement->spacesCount, entityElement->dataFormatType, entityElement->ownFormatType, entityElement->formatStart, entityElement->formatEnd, entityElement->hasPipe, entityElement->data);
-      }
+  return hash;
+}
 
-      for (unsigned int j = 0; j < xmlTag->wTagCount; ++j) {
-        wTag = &xmlTag->wikiTags[j];
-        writeOutTagData(parserRunTimeData, wTag);
-      }
-    }
-  #else
-    // SORTED WRITE OUT
-    for (unsigned int i = 0; i < xmlCollection->count; ++i) {
-      xmlTag = &xmlCollection->nodes[i];
-      fprintf(parserRunTimeData->xmltagFile, "%x\t%x\t%d\t%d\t%s\n", xmlTag->start , xmlTag->end, xmlTag->isClosed, xmlTag->isDataNode, xmlTag->name);
+vocabularyEntry* addVocabularyWord(vocabularyTable *vocabulary, const char *data) {
+  const unsigned int hash = hashWord(data);
+  unsigned int index = hash & (vocabulary->size - 1);
 
-      for (unsigned int j = 0; j < xmlTag->keyValuePairs; ++j) {
-        fprintf(parserRunTimeData->xmldataFile, "%x\t%x\t%s\t%s\n", xmlTag->start, xmlTag->end, xmlTag->keyValues[j].key, xmlTag->keyValues[j].value);
-      }
+  while (vocabulary->entries[index].data != NULL) {
+    if (vocabulary->entries[index].hash == hash && strcmp(vocabulary->entries[index].data, data) == 0) {
+      ++vocabulary->entries[index].count;
+      return &vocabulary->entries[index];
     }
+    index = (index + 1) & (vocabulary->size - 1);
+  }
 
-    unsigned int lineNum = 1;
-    unsigned int lastChecked = 0;
-    while (lineNum <= parserRunTimeData->currentLine) {
-      for (unsigned int i = lastChecked; i < xmlCollection->count; ++i) {
-        xmlTag = &xmlCollection->nodes[i];
-        if (xmlTag->start > lineNum) break;
-        lastChecked = i;
+  // NOTE: Kept below 3/4 load, the size stays a power of two
+  if ((vocabulary->count + 1) * 4 >= vocabulary->size * 3) {
+    growVocabulary(vocabulary);
+    index = hash & (vocabulary->size - 1);
+    while (vocabulary->entries[index].data != NULL) index = (index + 1) & (vocabulary->size - 1);
+  }
 
+  memset(&vocabulary->entries[index], 0, sizeof(vocabularyEntry));
+  vocabulary->entries[index].hash = hash;
+  vocabulary->entries[index].count = 1;
+  vocabulary->entries[index].data = malloc(sizeof(char) * (strlen(data) + 1));
+  strcpy(vocabulary->entries[index].data, data);
+  ++vocabulary->count;
 
-        for (unsigned int j = 0; j < xmlTag->wordCount; ++j) {
-          wordElement = &xmlTag->words[j];
-          if (wordElement->lineNum == lineNum) {
-            fprintf(parserRunTimeData->dictFile, "%x\t%x\t%d\t%x\t%x\t%ld\t%d\t%d\t%d\t%d\t%d\t%s\n", wordElement->position, wordElement->lineNum, -1, wordElement->preSpacesCount, wordElement->spacesCount, strlen(wordElement->data), wordElement->dataFormatType, wordElement->ownFormatType, wordElement->formatStart, wordElement->formatEnd, wordElement->hasPipe, wordElement->data);
-          }
-        }
+  return &vocabulary->entries[index];
+}
 
-        for (unsigned int j = 0; j < xmlTag->entityCount; ++j) {
-          entityElement = &xmlTag->entities[j];
-          if (entityElement->lineNum == lineNum) {
-            fprintf(parserRunTimeData->entitiesFile, "%x\t%x\t%d\t%x\t%x\t%d\t%d\t%d\t%d\t%d\t%s\n",  entityElement->position, entityElement->lineNum, -1, entityElement->preSpacesCount, entityElement->spacesCount, entityElement->dataFormatType, entityElement->ownFormatType, entityElement->formatStart, entityElement->formatEnd, entityElement->hasPipe, entityElement->data);
-          }
-        }
+static inline unsigned short encodeVarint(unsigned char *data, unsigned int value) {
+  unsigned short length = 0;
 
-        for (unsigned int j = 0; j < xmlTag->wTagCount; ++j) {
-          wTag = &xmlTag->wikiTags[j];
-          if (wTag->lineNum == lineNum) {
-            writeOutTagDataByLine(parserRunTimeData, wTag, lineNum);
-          }
-        }
-      }
+  while (value >= 0x80) {
+    data[length++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  data[length++] = value;
 
-      ++lineNum;
-    }
+  return length;
+}
 
-  #endif
-  return true;
+static inline unsigned int decodeVarint(const unsigned char *data, unsigned int *readerPos) {
+  unsigned int value = 0;
+  unsigned short shift = 0;
+
+  do {
+    value |= (unsigned int) (data[*readerPos] & 0x7F) << shift;
+    shift += 7;
+  } while (data[(*readerPos)++] & 0x80);
+
+  return value;
 }
 
-// ----------------------------------------------------------
+/*
+  NOTE: Appends a posting as varint of the page difference and varint of the
+        position, the position is the difference to the last one on the same
+        page. Pages are counted from 1 in dump order, 0 is ahead of the first.
+*/
+void addPosting(vocabularyEntry *entry, const unsigned int page, const unsigned int position) {
+  const bool isSamePage = entry->postingsLength != 0 && page == entry->lastPage;
 
-bool writeOutTagDataByLine(const struct parserBaseStore* parserRunTimeData, wikiTag *wTag, const unsigned int lineNum) {
-  struct word* wordElement = NULL;
-  struct entity* entityElement = NULL;
-  struct wikiTag* wikiTagElement = NULL;
+  if (entry->postingsLength + 10 > entry->postingsSize) {
+    entry->postingsSize = entry->postingsSize == 0 ? 16 : entry->postingsSize * 2;
+    entry->postings = (unsigned char*) realloc(entry->postings, sizeof(unsigned char) * entry->postingsSize);
+  }
 
-  fprintf(parserRunTimeData->wtagFile, "%x\t%x\t%x\t%x\t%d\t%d\t%d\t%d\t%d\t%d\t%lu\t%d\t%s\n",  wTag->position, wTag->lineNum, wTag->preSpacesCount, wTag->spacesCount, wTag->tagType, wTag->dataFormatType, wTag->ownFormatType, wTag->formatStart, wTag->formatEnd, wTag->tagLength, strlen(wTag->target), wTag->hasPipe, wTag->target);
+  entry->postingsLength += encodeVarint(&entry->postings[entry->postingsLength], page - entry->lastPage);
+  entry->postingsLength += encodeVarint(&entry->postings[entry->postingsLength], isSamePage ? position - entry->lastPosition : position);
 
-  for (unsigned int k = 0; k < wTag->wTagCount; ++k) {
-    wikiTagElement = &wTag->pipedTags[k];
-    writeOutTagDataByLine(parserRunTimeData, wikiTagElement, lineNum);
+  if (!isSamePage) ++entry->pageCount;
+  entry->lastPage = page;
+  entry->lastPosition = position;
+}
+
+/*
+  NOTE: Writes the postings with page ids in place of the page counts and
+        returns their length, nothing is written without a file. Differences
+        are taken modulo 2^32, so page ids out of order or pages sharing an
+        id decode as well.
+*/
+unsigned long long translatePostings(const vocabularyEntry *entry, const xmlDataCollection *xmlCollection, FILE *outputFile) {
+  unsigned char data[10];
+  unsigned long long postingsLength = 0;
+  unsigned int readerPos = 0;
+  unsigned int page = 0;
+  unsigned int position = 0;
+  unsigned int pageId = 0;
+  unsigned int lastPageId = 0;
+  unsigned int lastPosition = 0;
+  unsigned short length = 0;
+
+  while (readerPos < entry->postingsLength) {
+    const unsigned int pageDelta = decodeVarint(entry->postings, &readerPos);
+
+    page += pageDelta;
+    position = pageDelta == 0 ? lastPosition + decodeVarint(entry->postings, &readerPos) : decodeVarint(entry->postings, &readerPos);
+    pageId = page == 0 ? 0 : xmlCollection->pages[page - 1].pageId;
+
+    length = encodeVarint(data, pageId - lastPageId);
+    length += encodeVarint(&data[length], postingsLength != 0 && pageId == lastPageId ? position - lastPosition : position);
+
+    if (outputFile != NULL) fwrite(data, 1, length, outputFile);
+    postingsLength += length;
+    lastPageId = pageId;
+    lastPosition = position;
   }
 
-  for (unsigned int k = 0; k < wTag->wordCount; ++k) {
-    wordElement = &wTag->pipedWords[k];
-    fprintf(parserRunTimeData->dictFile, "%x\t%x\t%d\t%x\t%x\t%ld\t%d\t%d\t%d\t%d\t%d\t%s\n", wordElement->position, wordElement->lineNum, wTag->position, wordElement->preSpacesCount, wordElement->spacesCount, strlen(wordElement->data), wordElement->dataFormatType, wordElement->ownFormatType, wordElement->formatStart, wordElement->formatEnd, wordElement->hasPipe, wordElement->data);
+  return postingsLength;
+}
+
+void growVocabulary(vocabularyTable *vocabulary) {
+  vocabularyEntry *entries = vocabulary->entries;
+  const unsigned int size = vocabulary->size;
+  unsigned int index = 0;
+
+  vocabulary->size *= 2;
+  vocabulary->entries = calloc(vocabulary->size, sizeof(vocabularyEntry));
+
+  for (unsigned int i = 0; i < size; ++i) {
+    if (entries[i].data == NULL) continue;
+
+    index = entries[i].hash & (vocabulary->size - 1);
+    while (vocabulary->entries[index].data != NULL) index = (index + 1) & (vocabulary->size - 1);
+    vocabulary->entries[index] = entries[i];
   }
 
-  for (unsigned int k = 0; k < wTag->entityCount; ++k) {
-    entityElement = &wTag->pipedEntities[k];
-    fprintf(parserRunTimeData->entitiesFile, "%x\t%x\t%d\t%x\t%d\t%d\t%d\t%d\t%d\t%d\t%s\n",  entityElement->position, entityElement->lineNum, wTag->position, entityElement->preSpacesCount, entityElement->spacesCount, entityElement->dataFormatType, entityElement->ownFormatType, entityElement->formatStart, entityElement->formatEnd, entityElement->hasPipe, entityElement->data);
+  free(entries);
+}
+
+vocabularyEntry* findVocabularyWord(const vocabularyTable *vocabulary, const char *data) {
+  const unsigned int hash = hashWord(data);
+  unsigned int index = hash & (vocabulary->size - 1);
+
+  while (vocabulary->entries[index].data != NULL) {
+    if (vocabulary->entries[index].hash == hash && strcmp(vocabulary->entries[index].data, data) == 0) return &vocabulary->entries[index];
+    index = (index + 1) & (vocabulary->size - 1);
   }
 
-  return true;
+  return NULL;
 }
 
-bool writeOutTagData(const struct parserBaseStore* parserRunTimeData, wikiTag *wTag) {
-  struct word* wordElement = NULL;
-  struct entity* entityElement = NULL;
-  struct wikiTag* wikiTagElement = NULL;
+int compareVocabularyWords(const void *a, const void *b) {
+  return strcmp((*(const vocabularyEntry**) a)->data, (*(const vocabularyEntry**) b)->data);
+}
 
-  fprintf(parserRunTimeData->wtagFile, "%x\t%x\t%x\t%x\t%d\t%d\t%d\t%d\t%d\t%d\t%lu\t%d\t%s\n",  wTag->position, wTag->lineNum, wTag->preSpacesCount, wTag->spacesCount, wTag->tagType, wTag->dataFormatType, wTag->ownFormatType, wTag->formatStart, wTag->formatEnd, wTag->tagLength, strlen(wTag->target), wTag->hasPipe, wTag->target);
+// Descending by count, words of the same count in bytewise order
+int compareVocabularyCounts(const void *a, const void *b) {
+  const vocabularyEntry *entryA = *(const vocabularyEntry**) a;
+  const vocabularyEntry *entryB = *(const vocabularyEntry**) b;
 
+  if (entryA->count != entryB->count) return entryA->count > entryB->count ? -1 : 1;
+  return strcmp(entryA->data, entryB->data);
+}
 
-  for (unsigned int k = 0; k < wTag->wordCount; ++k) {
-    wordElement = &wTag->pipedWords[k];
-    fprintf(parserRunTimeData->dictFile, "%x\t%x\t%x\t%x\t%x\t%ld\t%d\t%d\t%d\t%d\t%d\t%s\n", wordElement->position, wordElement->lineNum, wTag->position, wordElement->preSpacesCount, wordElement->spacesCount, strlen(wordElement->data), wordElement->dataFormatType, wordElement->ownFormatType, wordElement->formatStart, wordElement->formatEnd, wordElement->hasPipe, wordElement->data);
+/*
+  NOTE: Ranks the words by their count, the most frequent word gets rank 0,
+        and writes the ranked dictionary with rank, count and word per row.
+*/
+bool rankVocabulary(vocabularyTable *vocabulary) {
+  FILE *dictionaryFile = fopen(RANKEDDICTIONARYFILE, "w");
+  vocabularyEntry **words = malloc(sizeof(vocabularyEntry*) * (vocabulary->count + 1));
+  unsigned int wordCount = 0;
+
+  for (unsigned int i = 0; i < vocabulary->size; ++i) {
+    if (vocabulary->entries[i].data != NULL) words[wordCount++] = &vocabulary->entries[i];
+  }
+  qsort(words, wordCount, sizeof(vocabularyEntry*), compareVocabularyCounts);
+
+  for (unsigned int i = 0; i < wordCount; ++i) {
+    words[i]->rank = i;
+    if (dictionaryFile != NULL) fprintf(dictionaryFile, "%u\t%u\t%s\n", i, words[i]->count, words[i]->data);
   }
 
+  free(words);
+  return dictionaryFile != NULL && fclose(dictionaryFile) == 0;
+}
 
-  for (unsigned int k = 0; k < wTag->entityCount; ++k) {
-    entityElement = &wTag->pipedEntities[k];
-    fprintf(parserRunTimeData->entitiesFile, "%x\t%x\t%x\t%x\t%x\t%d\t%d\t%d\t%d\t%d\t%s\n",  entityElement->position, entityElement->lineNum, wTag->position, entityElement->preSpacesCount, entityElement->spacesCount, entityElement->dataFormatType, entityElement->ownFormatType, entityElement->formatStart, entityElement->formatEnd, entityElement->hasPipe, entityElement->data);
+void writeVarint(FILE *outputFile, unsigned long long value) {
+  while (value >= 0x80) {
+    fputc((value & 0x7F) | 0x80, outputFile);
+    value >>= 7;
   }
+  fputc(value, outputFile);
+}
 
-  for (unsigned int k = 0; k < wTag->wTagCount; ++k) {
-    wikiTagElement = &wTag->pipedTags[k];
-    writeOutTagData(parserRunTimeData, wikiTagElement);
+/*
+  NOTE: Writes the sorted words front coded in blocks of VOCABULARYBLOCK words,
+        see wickedbinary.h. The id of a word is its place in the sorted order.
+*/
+bool writeOutVocabulary(const vocabularyTable *vocabulary) {
+  FILE *vocabularyFile = fopen(VOCABULARYFILE, "wb");
+  const unsigned int blockCount = (vocabulary->count + VOCABULARYBLOCK - 1) / VOCABULARYBLOCK;
+  const vocabularyEntry **words = NULL;
+  unsigned long long *blockOffsets = NULL;
+  unsigned long long dataLength = 0;
+  unsigned int wordCount = 0;
+
+  if (vocabularyFile == NULL) return false;
+
+  words = malloc(sizeof(vocabularyEntry*) * (vocabulary->count + 1));
+  for (unsigned int i = 0; i < vocabulary->size; ++i) {
+    if (vocabulary->entries[i].data != NULL) words[wordCount++] = &vocabulary->entries[i];
   }
-  return true;
+  qsort(words, wordCount, sizeof(vocabularyEntry*), compareVocabularyWords);
+
+  fwrite(WICKEDVOCABULARYMAGIC, 1, 4, vocabularyFile);
+  writeBinaryUnsigned(vocabularyFile, WICKEDVOCABULARYVERSION, 4);
+  writeBinaryUnsigned(vocabularyFile, wordCount, 4);
+  writeBinaryUnsigned(vocabularyFile, VOCABULARYBLOCK, 4);
+  writeBinaryUnsigned(vocabularyFile, blockCount, 4);
+  writeBinaryUnsigned(vocabularyFile, 0, 4);
+  writeBinaryUnsigned(vocabularyFile, 0, 8);
+
+  // NOTE: Offsets and data length are written once the blocks are known
+  blockOffsets = malloc(sizeof(unsigned long long) * (blockCount + 1));
+  fseek(vocabularyFile, WICKEDVOCABULARYHEADERSIZE + blockCount * 8ULL, SEEK_SET);
+
+  for (unsigned int i = 0; i < wordCount; ++i) {
+    const char *data = words[i]->data;
+    unsigned int prefixLength = 0;
+
+    if (i % VOCABULARYBLOCK == 0) blockOffsets[i / VOCABULARYBLOCK] = ftell(vocabularyFile) - (WICKEDVOCABULARYHEADERSIZE + blockCount * 8ULL);
+    else {
+      const char *lastData = words[i - 1]->data;
+      while (data[prefixLength] != '\0' && data[prefixLength] == lastData[prefixLength]) ++prefixLength;
+      writeVarint(vocabularyFile, prefixLength);
+    }
+
+    writeVarint(vocabularyFile, strlen(&data[prefixLength]));
+    fputs(&data[prefixLength], vocabularyFile);
+  }
+
+  dataLength = ftell(vocabularyFile) - (WICKEDVOCABULARYHEADERSIZE + blockCount * 8ULL);
+  fseek(vocabularyFile, 24, SEEK_SET);
+  writeBinaryUnsigned(vocabularyFile, dataLength, 8);
+  for (unsigned int i = 0; i < blockCount; ++i) writeBinaryUnsigned(vocabularyFile, blockOffsets[i], 8);
+
+  free(blockOffsets);
+  free(words);
+  return fclose(vocabularyFile) == 0;
+}
+
+/*
+  NOTE: Writes the inverted index described in wickedbinary.h, the terms are
+        sorted as in the vocabulary file, so both share the word ids.
+*/
+bool writeOutInvertedIndex(const vocabularyTable *vocabulary, const xmlDataCollection *xmlCollection) {
+  FILE *indexFile = fopen(INVERTEDINDEXFILE, "wb");
+  const vocabularyEntry **words = NULL;
+  unsigned long long *postingsLengths = NULL;
+  unsigned long long termsLength = 0;
+  unsigned long long postingsLength = 0;
+  unsigned long long postingsStart = 0;
+  unsigned int wordCount = 0;
+
+  if (indexFile == NULL) return false;
+
+  words = malloc(sizeof(vocabularyEntry*) * (vocabulary->count + 1));
+  for (unsigned int i = 0; i < vocabulary->size; ++i) {
+    if (vocabulary->entries[i].data != NULL) words[wordCount++] = &vocabulary->entries[i];
+  }
+  qsort(words, wordCount, sizeof(vocabularyEntry*), compareVocabularyWords);
+
+  postingsLengths = malloc(sizeof(unsigned long long) * (wordCount + 1));
+  for (unsigned int i = 0; i < wordCount; ++i) {
+    termsLength += strlen(words[i]->data) + 1;
+    postingsLengths[i] = translatePostings(words[i], xmlCollection, NULL);
+    postingsLength += postingsLengths[i];
+  }
+
+  // NOTE: The postings start 8 byte aligned after the terms
+  postingsStart = (WICKEDPOSTINGSHEADERSIZE + wordCount * (unsigned long long) WICKEDTERMENTRYSIZE + termsLength + 7) & ~7ULL;
+
+  fwrite(WICKEDPOSTINGSMAGIC, 1, 4, indexFile);
+  writeBinaryUnsigned(indexFile, WICKEDPOSTINGSVERSION, 4);
+  writeBinaryUnsigned(indexFile, wordCount, 4);
+  writeBinaryUnsigned(indexFile, 0, 4);
+  writeBinaryUnsigned(indexFile, termsLength, 8);
+  writeBinaryUnsigned(indexFile, postingsLength, 8);
+
+  termsLength = 0;
+  postingsLength = 0;
+  for (unsigned int i = 0; i < wordCount; ++i) {
+    writeBinaryUnsigned(indexFile, postingsLength, 8);
+    writeBinaryUnsigned(indexFile, postingsLengths[i], 4);
+    writeBinaryUnsigned(indexFile, words[i]->count, 4);
+    writeBinaryUnsigned(indexFile, words[i]->pageCount, 4);
+    writeBinaryUnsigned(indexFile, termsLength, 4);
+
+    termsLength += strlen(words[i]->data) + 1;
+    postingsLength += postingsLengths[i];
+  }
+
+  for (unsigned int i = 0; i < wordCount; ++i) fwrite(words[i]->data, 1, strlen(words[i]->data) + 1, indexFile);
+  while ((unsigned long long) ftell(indexFile) < postingsStart) fputc(0, indexFile);
+
+  for (unsigned int i = 0; i < wordCount; ++i) translatePostings(words[i], xmlCollection, indexFile);
+
+  free(postingsLengths);
+  free(words);
+  return fclose(indexFile) == 0;
 }
 
+void freeVocabulary(vocabularyTable *vocabulary) {
+  for (unsigned int i = 0; i < vocabulary->size; ++i) {
+    free(vocabulary->entries[i].data);
+    free(vocabulary->entries[i].postings);
+  }
+  free(vocabulary->entries);
+  vocabulary->entries = NULL;
+  vocabulary->size = 0;
+  vocabulary->count = 0;
+}
 
 //------------------------------------------------------------------------------
 
-void freeXMLCollection(xmlDataCollection *xmlCollection) {
-  xmlNode *xmlTag = NULL;
+void initTargets(targetTable *targets) {
+  targets->size = TARGETTABLESIZE;
+  targets->count = 0;
+  targets->slots = calloc(targets->size, sizeof(unsigned int));
+  targets->hashes = malloc(sizeof(unsigned int) * targets->size);
+  targets->data = malloc(sizeof(char*) * targets->size);
+}
 
-  for (unsigned int i = 0; i < xmlCollection->count; ++i) {
-    xmlTag = &xmlCollection->nodes[i];
+/*
+  NOTE: Returns the id of the target. With NORMALIZETARGETS the targets naming
+        a page are normalized first, so "united_States" and "United States"
+        share their id. Wiktionary keeps the case of the first letter, table,
+        math and reference targets are kept as they are.
+*/
+unsigned int internTarget(targetTable *targets, const char *target, const short tagType) {
+  const bool isPageTarget = NORMALIZETARGETS && (tagType == 1 || (tagType >= 3 && tagType <= 12 && tagType != 8));
+  char normalized[strlen(target) + 1];
+  const char *data = target;
+  unsigned int hash = 0;
+  unsigned int index = 0;
+
+  if (isPageTarget) {
+    normalizeTitle(normalized, target, false);
+    data = normalized;
+  }
 
-    for (unsigned int j = 0; j < xmlTag->keyValuePairs; ++j) {
-      free(xmlTag->keyValues[j].key);
-      free(xmlTag->keyValues[j].value);
-    }
+  hash = hashWord(data);
+  index = hash & (targets->size - 1);
 
-    for (unsigned int j = 0; j < xmlTag->wordCount; ++j) free(xmlTag->words[j].data);
-    for (unsigned int j = 0; j < xmlTag->wTagCount; ++j) freeXMLCollectionTag(&xmlTag->wikiTags[j]);
+  while (targets->slots[index] != 0) {
+    const unsigned int id = targets->slots[index] - 1;
+    if (targets->hashes[id] == hash && strcmp(targets->data[id], data) == 0) return id;
+    index = (index + 1) & (targets->size - 1);
+  }
 
-    free(xmlTag->name);
-    free(xmlTag->keyValues);
-    free(xmlTag->words);
-    free(xmlTag->entities);
-    free(xmlTag->wikiTags);
+  // NOTE: Kept below 3/4 load, the size stays a power of two
+  if ((targets->count + 1) * 4 >= targets->size * 3) {
+    growTargets(targets);
+    index = hash & (targets->size - 1);
+    while (targets->slots[index] != 0) index = (index + 1) & (targets->size - 1);
   }
 
-  free(xmlCollection->nodes);
-  free(xmlCollection->openNodes);
+  targets->slots[index] = targets->count + 1;
+  targets->hashes[targets->count] = hash;
+  targets->data[targets->count] = malloc(sizeof(char) * (strlen(data) + 1));
+  strcpy(targets->data[targets->count], data);
 
-  #if DEBUG
-  printf("[DEBUG] Successfully cleaned up xmlCollection...\n");
-  #endif
+  return targets->count++;
+}
 
-  return;
+void growTargets(targetTable *targets) {
+  unsigned int index = 0;
+
+  targets->size *= 2;
+  free(targets->slots);
+  targets->slots = calloc(targets->size, sizeof(unsigned int));
+  targets->hashes = (unsigned int*) realloc(targets->hashes, sizeof(unsigned int) * targets->size);
+  targets->data = (char**) realloc(targets->data, sizeof(char*) * targets->size);
+
+  for (unsigned int i = 0; i < targets->count; ++i) {
+    index = targets->hashes[i] & (targets->size - 1);
+    while (targets->slots[index] != 0) index = (index + 1) & (targets->size - 1);
+    targets->slots[index] = i + 1;
+  }
 }
 
-void freeXMLCollectionTag(wikiTag *wTag) {
-  for (unsigned int i = 0; i < wTag->wordCount; ++i) {
-    free(wTag->pipedWords[i].data);
+/*
+  NOTE: Writes the title as MediaWiki compares titles, underscores read as
+        spaces, spaces trimmed and collapsed and the first letter in upper
+        case. Only ASCII letters are changed. Links also lose a leading colon
+        and the "#section". Returns the length of the normalized title.
+*/
+unsigned int normalizeTitle(char *normalized, const char *title, const bool isLink) {
+  unsigned int writerPos = 0;
+  bool isSpace = false;
+
+  while (*title == ' ') ++title;
+  if (isLink && *title == ':') ++title;
+
+  for (; *title != '\0' && (!isLink || *title != '#'); ++title) {
+    if (*title == ' ' || *title == '_' || *title == '\t' || *title == '\n' || *title == '\r') {
+      isSpace = true;
+      continue;
+    }
+
+    if (isSpace && writerPos != 0) normalized[writerPos++] = ' ';
+    isSpace = false;
+    normalized[writerPos++] = *title;
   }
 
-  for (unsigned int i = 0; i < wTag->wTagCount; ++i) {
-    freeXMLCollectionTag(&wTag->pipedTags[i]);
+  normalized[writerPos] = '\0';
+  if ((unsigned char) normalized[0] < 0x80) normalized[0] = toupper(normalized[0]);
+
+  return writerPos;
+}
+
+// NOTE: Lists the targets by id, one "id\ttarget" row each
+bool writeOutTargets(const targetTable *targets) {
+  FILE *targetsFile = fopen(TARGETSFILE, "w");
+
+  if (targetsFile == NULL) return false;
+
+  for (unsigned int i = 0; i < targets->count; ++i) fprintf(targetsFile, "%u\t%s\n", i, targets->data[i]);
+
+  return fclose(targetsFile) == 0;
+}
+
+void freeTargets(targetTable *targets) {
+  for (unsigned int i = 0; i < targets->count; ++i) free(targets->data[i]);
+  free(targets->slots);
+  free(targets->hashes);
+  free(targets->data);
+  targets->slots = NULL;
+  targets->hashes = NULL;
+  targets->data = NULL;
+  targets->size = 0;
+  targets->count = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void initLinks(linkTable *links) {
+  links->size = LINKTABLESIZE;
+  links->count = 0;
+  links->pages = malloc(sizeof(unsigned int) * links->size);
+  links->targets = malloc(sizeof(unsigned int) * links->size);
+}
+
+void addLink(linkTable *links, const unsigned int page, const unsigned int target) {
+  if (links->count == links->size) {
+    links->size *= 2;
+    links->pages = (unsigned int*) realloc(links->pages, sizeof(unsigned int) * links->size);
+    links->targets = (unsigned int*) realloc(links->targets, sizeof(unsigned int) * links->size);
   }
 
-  free(wTag->target);
-  free(wTag->pipedWords);
-  free(wTag->pipedTags);
-  free(wTag->pipedEntities);
+  links->pages[links->count] = page;
+  links->targets[links->count] = target;
+  ++links->count;
+}
 
-  return;
+/*
+  NOTE: Writes the link graph described in wickedbinary.h, the targets are
+        found by the normalized titles of the pages, the first page wins for
+        titles given twice. Links to a "#section" only point to their own page,
+        redirect pages are nodes of their own. Links not found, interlanguage
+        links among them, are listed by page id in UNRESOLVEDLINKSFILE.
+*/
+bool writeOutLinkGraph(const linkTable *links, const targetTable *targets, const xmlDataCollection *xmlCollection) {
+  FILE *graphFile = fopen(LINKGRAPHFILE, "wb");
+  FILE *unresolvedFile = NULL;
+  const unsigned int pageCount = xmlCollection->pageCount;
+  unsigned int tableSize = 16;
+  unsigned int *titleTable = NULL;
+  unsigned int *records = NULL;
+  unsigned int *linkTargets = NULL;
+  unsigned long long *offsets = NULL;
+  pageOrder *order = NULL;
+  bool *isFound = NULL;
+  char **titles = NULL;
+  char *normalized = NULL;
+  unsigned int normalizedSize = 0;
+  unsigned int target = 0;
+  unsigned int unresolvedCount = 0;
+  unsigned int index = 0;
+  unsigned int page = 0;
+  unsigned long long linkCount = 0;
+
+  if (graphFile == NULL) return false;
+
+  unresolvedFile = fopen(UNRESOLVEDLINKSFILE, "w");
+  if (unresolvedFile == NULL) {
+    fclose(graphFile);
+    return false;
+  }
+
+  // NOTE: Open addressing by the record number + 1 of the page, 0 is a free slot
+  while (tableSize < pageCount * 2ULL) tableSize *= 2;
+  titleTable = calloc(tableSize, sizeof(unsigned int));
+  titles = malloc(sizeof(char*) * (pageCount + 1));
+
+  for (unsigned int i = 0; i < pageCount; ++i) {
+    const char *title = xmlCollection->pages[i].title == NULL ? "" : xmlCollection->pages[i].title;
+
+    titles[i] = malloc(sizeof(char) * (strlen(title) + 1));
+    normalizeTitle(titles[i], title, false);
+
+    index = hashWord(titles[i]) & (tableSize - 1);
+    while (titleTable[index] != 0 && strcmp(titles[titleTable[index] - 1], titles[i]) != 0) index = (index + 1) & (tableSize - 1);
+    if (titleTable[index] == 0) titleTable[index] = i + 1;
+  }
+
+  /*
+    NOTE: Each target is looked up once, "records" holds the record + 1 of its
+          page, 0 if not found and UINT_MAX for a link to the own page.
+          The links come in dump order, so the targets of a page follow each other.
+  */
+  records = malloc(sizeof(unsigned int) * (targets->count + 1));
+  isFound = calloc(targets->count + 1, sizeof(bool));
+  linkTargets = malloc(sizeof(unsigned int) * (links->count + 1));
+  offsets = calloc(pageCount + 1, sizeof(unsigned long long));
+
+  for (unsigned int i = 0; i < links->count; ++i) {
+    const unsigned int targetLength = strlen(targets->data[links->targets[i]]);
+
+    // NOTE: Links ahead of the first page have no page to start from
+    page = links->pages[i];
+    target = links->targets[i];
+    if (page == 0) continue;
+
+    if (targetLength + 1 > normalizedSize) {
+      normalizedSize = targetLength + 1;
+      normalized = (char*) realloc(normalized, sizeof(char) * normalizedSize);
+    }
+
+    if (!isFound[target]) {
+      normalizeTitle(normalized, targets->data[target], true);
+
+      if (normalized[0] == '\0') records[target] = UINT_MAX;
+      else {
+        index = hashWord(normalized) & (tableSize - 1);
+        while (titleTable[index] != 0 && strcmp(titles[titleTable[index] - 1], normalized) != 0) index = (index + 1) & (tableSize - 1);
+        records[target] = titleTable[index];
+      }
+      isFound[target] = true;
+    }
+
+    index = records[target] == UINT_MAX ? page : records[target];
+
+    if (index == 0) {
+      normalizeTitle(normalized, targets->data[target], true);
+      fprintf(unresolvedFile, "%u\t%s\n", xmlCollection->pages[page - 1].pageId, normalized);
+      ++unresolvedCount;
+      continue;
+    }
+
+    linkTargets[linkCount++] = index - 1;
+    ++offsets[page];
+  }
+
+  for (unsigned int i = 0; i < pageCount; ++i) offsets[i + 1] += offsets[i];
+
+  fwrite(WICKEDGRAPHMAGIC, 1, 4, graphFile);
+  writeBinaryUnsigned(graphFile, WICKEDGRAPHVERSION, 4);
+  writeBinaryUnsigned(graphFile, pageCount, 4);
+  writeBinaryUnsigned(graphFile, unresolvedCount, 4);
+  writeBinaryUnsigned(graphFile, linkCount, 8);
+
+  for (unsigned int i = 0; i <= pageCount; ++i) writeBinaryUnsigned(graphFile, offsets[i], 8);
+  for (unsigned int i = 0; i < pageCount; ++i) writeBinaryUnsigned(graphFile, xmlCollection->pages[i].pageId, 4);
+  for (unsigned long long i = 0; i < linkCount; ++i) writeBinaryUnsigned(graphFile, linkTargets[i], 4);
+
+  order = malloc(sizeof(pageOrder) * (pageCount + 1));
+  for (unsigned int i = 0; i < pageCount; ++i) {
+    order[i].title = NULL;
+    order[i].pageId = xmlCollection->pages[i].pageId;
+    order[i].record = i;
+  }
+
+  qsort(order, pageCount, sizeof(pageOrder), comparePageIds);
+  for (unsigned int i = 0; i < pageCount; ++i) writeBinaryUnsigned(graphFile, order[i].record, 4);
+
+  #if DEBUG || BEVERBOSE
+  printf("[STATUS] %u UNRESOLVED LINKS IN %s\n", unresolvedCount, UNRESOLVEDLINKSFILE);
+  #endif
+
+  for (unsigned int i = 0; i < pageCount; ++i) free(titles[i]);
+  free(titles);
+  free(titleTable);
+  free(records);
+  free(isFound);
+  free(linkTargets);
+  free(offsets);
+  free(order);
+  free(normalized);
+  fclose(unresolvedFile);
+  return fclose(graphFile) == 0;
+}
+
+void freeLinks(linkTable *links) {
+  free(links->pages);
+  free(links->targets);
+  links->pages = NULL;
+  links->targets = NULL;
+  links->size = 0;
+  links->count = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void initSharedTags(sharedTagTable *sharedTags) {
+  sharedTags->size = SHAREDTAGTABLESIZE;
+  sharedTags->count = 0;
+  sharedTags->useCount = 0;
+  sharedTags->entries = calloc(sharedTags->size, sizeof(sharedTag*));
+}
+
+/*
+  NOTE: Makes the completed wikitag share its children with the canonical copy
+        of the same children or makes it the canonical copy. Wikitags without
+        children are left alone.
+*/
+void shareWikiTag(sharedTagTable *sharedTags, wikiTag *wTag) {
+  unsigned int hash = 0;
+  unsigned int index = 0;
+  sharedTag *entry = NULL;
+
+  if (wTag->wordCount + wTag->entityCount + wTag->wTagCount == 0 || !isShareableTag(wTag)) return;
+
+  hash = hashTagChildren(wTag);
+  index = hash & (sharedTags->size - 1);
+
+  while ((entry = sharedTags->entries[index]) != NULL) {
+    if (entry->hash == hash && isSameTagChildren(wTag, &entry->tag)) break;
+    index = (index + 1) & (sharedTags->size - 1);
+  }
+
+  if (entry != NULL) freeXMLCollectionTag(wTag);
+  else {
+    // NOTE: Kept below 3/4 load, the size stays a power of two
+    if ((sharedTags->count + 1) * 4 >= sharedTags->size * 3) {
+      growSharedTags(sharedTags);
+      index = hash & (sharedTags->size - 1);
+      while (sharedTags->entries[index] != NULL) index = (index + 1) & (sharedTags->size - 1);
+    }
+
+    entry = malloc(sizeof(sharedTag));
+    entry->hash = hash;
+    entry->tag = *wTag;
+    sharedTags->entries[index] = entry;
+    ++sharedTags->count;
+  }
+
+  wTag->pipedWords = entry->tag.pipedWords;
+  wTag->pipedTags = entry->tag.pipedTags;
+  wTag->pipedEntities = entry->tag.pipedEntities;
+  wTag->shared = entry;
+  ++sharedTags->useCount;
+}
+
+/*
+  NOTE: Only children on the line of the wikitag are shared, positions count
+        from the start of each line. Nested wikitags have to be shared or
+        without children themselves.
+*/
+bool isShareableTag(const wikiTag *wTag) {
+  for (unsigned int i = 0; i < wTag->wordCount; ++i) {
+    if (wTag->pipedWords[i].lineNum != wTag->lineNum) return false;
+  }
+
+  for (unsigned int i = 0; i < wTag->entityCount; ++i) {
+    if (wTag->pipedEntities[i].lineNum != wTag->lineNum) return false;
+  }
+
+  for (unsigned int i = 0; i < wTag->wTagCount; ++i) {
+    const wikiTag *child = &wTag->pipedTags[i];
+    if (child->lineNum != wTag->lineNum) return false;
+    if (child->shared == NULL && child->wordCount + child->entityCount + child->wTagCount != 0) return false;
+  }
+
+  return true;
+}
+
+static inline unsigned int hashValue(unsigned int hash, const unsigned int value) {
+  for (unsigned short i = 0; i < 4; ++i) {
+    hash ^= (value >> (8 * i)) & 0xFF;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+// NOTE: FNV-1a over the children, positions relative to the wikitag
+unsigned int hashTagChildren(const wikiTag *wTag) {
+  unsigned int hash = 2166136261u;
+
+  for (unsigned int i = 0; i < wTag->wordCount; ++i) {
+    const word *child = &wTag->pipedWords[i];
+    hash = hashValue(hash, child->position - wTag->position);
+    hash = hashValue(hash, (child->dataFormatType & 0xFFFF) | (unsigned int) (child->ownFormatType & 0xFFFF) << 16);
+    hash = hashValue(hash, child->formatStart | child->formatEnd << 1 | child->hasPipe << 2 | child->preSpacesCount << 8 | child->spacesCount << 16);
+    hash = hashValue(hash, hashWord(child->data));
+  }
+
+  for (unsigned int i = 0; i < wTag->entityCount; ++i) {
+    const entity *child = &wTag->pipedEntities[i];
+    hash = hashValue(hash, child->position - wTag->position);
+    hash = hashValue(hash, hashWord(child->data));
+  }
+
+  for (unsigned int i = 0; i < wTag->wTagCount; ++i) {
+    const wikiTag *child = &wTag->pipedTags[i];
+    hash = hashValue(hash, child->position - wTag->position);
+    hash = hashValue(hash, child->tagType | child->hasPipe << 16);
+    hash = hashValue(hash, child->target);
+    hash = hashValue(hash, child->shared == NULL ? 0 : child->shared->hash);
+  }
+
+  return hash;
+}
+
+bool isSameTagChildren(const wikiTag *a, const wikiTag *b) {
+  if (a->wordCount != b->wordCount || a->entityCount != b->entityCount || a->wTagCount != b->wTagCount) return false;
+
+  for (unsigned int i = 0; i < a->wordCount; ++i) {
+    const word *childA = &a->pipedWords[i];
+    const word *childB = &b->pipedWords[i];
+
+    if (childA->position - a->position != childB->position - b->position) return false;
+    if (childA->dataFormatType != childB->dataFormatType || childA->ownFormatType != childB->ownFormatType) return false;
+    if (childA->formatStart != childB->formatStart || childA->formatEnd != childB->formatEnd || childA->hasPipe != childB->hasPipe) return false;
+    if (childA->preSpacesCount != childB->preSpacesCount || childA->spacesCount != childB->spacesCount) return false;
+    if (strcmp(childA->data, childB->data) != 0) return false;
+  }
+
+  for (unsigned int i = 0; i < a->entityCount; ++i) {
+    const entity *childA = &a->pipedEntities[i];
+    const entity *childB = &b->pipedEntities[i];
+
+    if (childA->position - a->position != childB->position - b->position) return false;
+    if (childA->dataFormatType != childB->dataFormatType || childA->ownFormatType != childB->ownFormatType) return false;
+    if (childA->formatStart != childB->formatStart || childA->formatEnd != childB->formatEnd || childA->hasPipe != childB->hasPipe) return false;
+    if (childA->preSpacesCount != childB->preSpacesCount || childA->spacesCount != childB->spacesCount) return false;
+    if (strcmp(childA->data, childB->data) != 0) return false;
+  }
+
+  for (unsigned int i = 0; i < a->wTagCount; ++i) {
+    const wikiTag *childA = &a->pipedTags[i];
+    const wikiTag *childB = &b->pipedTags[i];
+
+    if (childA->position - a->position != childB->position - b->position) return false;
+    if (childA->tagType != childB->tagType || childA->target != childB->target || childA->tagLength != childB->tagLength) return false;
+    if (childA->dataFormatType != childB->dataFormatType || childA->ownFormatType != childB->ownFormatType) return false;
+    if (childA->formatStart != childB->formatStart || childA->formatEnd != childB->formatEnd || childA->hasPipe != childB->hasPipe) return false;
+    if (childA->preSpacesCount != childB->preSpacesCount || childA->spacesCount != childB->spacesCount) return false;
+    // NOTE: Shared children are the same if they share the same copy
+    if (childA->shared != childB->shared) return false;
+  }
+
+  return true;
+}
+
+void growSharedTags(sharedTagTable *sharedTags) {
+  sharedTag **entries = sharedTags->entries;
+  const unsigned int size = sharedTags->size;
+  unsigned int index = 0;
+
+  sharedTags->size *= 2;
+  sharedTags->entries = calloc(sharedTags->size, sizeof(sharedTag*));
+
+  for (unsigned int i = 0; i < size; ++i) {
+    if (entries[i] == NULL) continue;
+
+    index = entries[i]->hash & (sharedTags->size - 1);
+    while (sharedTags->entries[index] != NULL) index = (index + 1) & (sharedTags->size - 1);
+    sharedTags->entries[index] = entries[i];
+  }
+
+  free(entries);
+}
+
+void freeSharedTags(sharedTagTable *sharedTags) {
+  for (unsigned int i = 0; i < sharedTags->size; ++i) {
+    if (sharedTags->entries[i] == NULL) continue;
+    freeXMLCollectionTag(&sharedTags->entries[i]->tag);
+    free(sharedTags->entries[i]);
+  }
+  free(sharedTags->entries);
+  sharedTags->entries = NULL;
+  sharedTags->size = 0;
+  sharedTags->count = 0;
+}
+
+/*
+  NOTE: Children of shared wikitags are copied with the position and line of
+        the wikitag, see sharedTag.
+*/
+static inline void shiftSharedChild(const wikiTag *wTag, unsigned int *position, unsigned int *lineNum) {
+  if (wTag->shared == NULL) return;
+  *position += wTag->position - wTag->shared->tag.position;
+  *lineNum += wTag->lineNum - wTag->shared->tag.lineNum;
+}
+
+//------------------------------------------------------------------------------
+
+void initFormatSpans(formatSpanTable *spans) {
+  spans->size = FORMATSPANTABLESIZE;
+  spans->count = 0;
+  spans->tokenSize = FORMATSPANTABLESIZE;
+  spans->tokenCount = 0;
+  spans->spans = malloc(sizeof(formatSpan) * spans->size);
+  spans->tokens = malloc(sizeof(formatToken) * spans->tokenSize);
+}
+
+static inline void addFormatToken(formatSpanTable *spans, const unsigned int lineNum, const unsigned int position, const short dataFormatType, const short ownFormatType) {
+  formatToken *token = NULL;
+
+  if (spans->tokenCount == spans->tokenSize) {
+    spans->tokenSize *= 2;
+    spans->tokens = (formatToken*) realloc(spans->tokens, sizeof(formatToken) * spans->tokenSize);
+  }
+
+  token = &spans->tokens[spans->tokenCount++];
+  token->lineNum = lineNum;
+  token->position = position;
+  token->outerFormatType = dataFormatType != -1 ? dataFormatType : ownFormatType;
+  token->nestedFormatType = ownFormatType != token->outerFormatType ? ownFormatType : -1;
+}
+
+/*
+  NOTE: Called once the data node is closed, the formats of its tokens are
+        final then. Spans of a node are kept in the order of their start,
+        nodes are closed in the order of their lines.
+*/
+void addNodeFormatSpans(formatSpanTable *spans, const xmlNode *xmlTag) {
+  const unsigned int firstSpan = spans->count;
+  const formatToken *outerStart = NULL;
+  const formatToken *nestedStart = NULL;
+  const formatToken *lastToken = NULL;
+  short outerFormatType = -1;
+  short nestedFormatType = -1;
+  bool isFormatted = false;
+
+  spans->tokenCount = 0;
+
+  for (unsigned int i = 0; i < xmlTag->wordCount; ++i) {
+    addFormatToken(spans, xmlTag->words[i].lineNum, xmlTag->words[i].position, xmlTag->words[i].dataFormatType, xmlTag->words[i].ownFormatType);
+  }
+
+  for (unsigned int i = 0; i < xmlTag->entityCount; ++i) {
+    addFormatToken(spans, xmlTag->entities[i].lineNum, xmlTag->entities[i].position, xmlTag->entities[i].dataFormatType, xmlTag->entities[i].ownFormatType);
+  }
+
+  for (unsigned int i = 0; i < xmlTag->wTagCount; ++i) {
+    addFormatToken(spans, xmlTag->wikiTags[i].lineNum, xmlTag->wikiTags[i].position, xmlTag->wikiTags[i].dataFormatType, xmlTag->wikiTags[i].ownFormatType);
+    addTagFormatTokens(spans, &xmlTag->wikiTags[i]);
+  }
+
+  for (unsigned int i = 0; i < spans->tokenCount && !isFormatted; ++i) isFormatted = spans->tokens[i].outerFormatType != -1;
+  if (!isFormatted) return;
+
+  qsort(spans->tokens, spans->tokenCount, sizeof(formatToken), compareFormatTokens);
+
+  for (unsigned int i = 0; i < spans->tokenCount; ++i) {
+    const formatToken *token = &spans->tokens[i];
+
+    if (token->outerFormatType != outerFormatType) {
+      if (outerFormatType != -1) addFormatSpan(spans, outerStart, lastToken, outerFormatType);
+      outerFormatType = token->outerFormatType;
+      outerStart = token;
+    }
+
+    if (token->nestedFormatType != nestedFormatType) {
+      if (nestedFormatType != -1) addFormatSpan(spans, nestedStart, lastToken, nestedFormatType);
+      nestedFormatType = token->nestedFormatType;
+      nestedStart = token;
+    }
+
+    lastToken = token;
+  }
+
+  if (outerFormatType != -1) addFormatSpan(spans, outerStart, lastToken, outerFormatType);
+  if (nestedFormatType != -1) addFormatSpan(spans, nestedStart, lastToken, nestedFormatType);
+
+  qsort(&spans->spans[firstSpan], spans->count - firstSpan, sizeof(formatSpan), compareFormatSpans);
+}
+
+// NOTE: Children of shared wikitags are taken shifted as in the write out
+void addTagFormatTokens(formatSpanTable *spans, const wikiTag *wTag) {
+  wikiTag wikiTagElement;
+  unsigned int position = 0;
+  unsigned int lineNum = 0;
+
+  for (unsigned int i = 0; i < wTag->wordCount; ++i) {
+    position = wTag->pipedWords[i].position;
+    lineNum = wTag->pipedWords[i].lineNum;
+    shiftSharedChild(wTag, &position, &lineNum);
+    addFormatToken(spans, lineNum, position, wTag->pipedWords[i].dataFormatType, wTag->pipedWords[i].ownFormatType);
+  }
+
+  for (unsigned int i = 0; i < wTag->entityCount; ++i) {
+    position = wTag->pipedEntities[i].position;
+    lineNum = wTag->pipedEntities[i].lineNum;
+    shiftSharedChild(wTag, &position, &lineNum);
+    addFormatToken(spans, lineNum, position, wTag->pipedEntities[i].dataFormatType, wTag->pipedEntities[i].ownFormatType);
+  }
+
+  for (unsigned int i = 0; i < wTag->wTagCount; ++i) {
+    wikiTagElement = wTag->pipedTags[i];
+    shiftSharedChild(wTag, &wikiTagElement.position, &wikiTagElement.lineNum);
+    addFormatToken(spans, wikiTagElement.lineNum, wikiTagElement.position, wikiTagElement.dataFormatType, wikiTagElement.ownFormatType);
+    addTagFormatTokens(spans, &wikiTagElement);
+  }
+}
+
+void addFormatSpan(formatSpanTable *spans, const formatToken *startToken, const formatToken *endToken, const short formatType) {
+  formatSpan *span = NULL;
+
+  if (spans->count == spans->size) {
+    spans->size *= 2;
+    spans->spans = (formatSpan*) realloc(spans->spans, sizeof(formatSpan) * spans->size);
+  }
+
+  span = &spans->spans[spans->count++];
+  span->startLine = startToken->lineNum;
+  span->startPosition = startToken->position;
+  span->endLine = endToken->lineNum;
+  span->endPosition = endToken->position;
+  span->formatType = formatType;
+}
+
+int compareFormatTokens(const void *a, const void *b) {
+  const formatToken *tokenA = (const formatToken*) a;
+  const formatToken *tokenB = (const formatToken*) b;
+
+  if (tokenA->lineNum != tokenB->lineNum) return tokenA->lineNum < tokenB->lineNum ? -1 : 1;
+  if (tokenA->position != tokenB->position) return tokenA->position < tokenB->position ? -1 : 1;
+  return 0;
+}
+
+// NOTE: Spans starting at the same token are ordered outer first
+int compareFormatSpans(const void *a, const void *b) {
+  const formatSpan *spanA = (const formatSpan*) a;
+  const formatSpan *spanB = (const formatSpan*) b;
+
+  if (spanA->startLine != spanB->startLine) return spanA->startLine < spanB->startLine ? -1 : 1;
+  if (spanA->startPosition != spanB->startPosition) return spanA->startPosition < spanB->startPosition ? -1 : 1;
+  if (spanA->endLine != spanB->endLine) return spanA->endLine > spanB->endLine ? -1 : 1;
+  if (spanA->endPosition != spanB->endPosition) return spanA->endPosition > spanB->endPosition ? -1 : 1;
+  return 0;
+}
+
+// NOTE: One row per span, "start line, start position, end line, end position, format type"
+bool writeOutFormatSpans(const formatSpanTable *spans) {
+  FILE *spansFile = fopen(FORMATSPANSFILE, "w");
+  if (spansFile == NULL) return false;
+
+  for (unsigned int i = 0; i < spans->count; ++i) {
+    const formatSpan *span = &spans->spans[i];
+    fprintf(spansFile, "%u\t%u\t%u\t%u\t%d\n", span->startLine, span->startPosition, span->endLine, span->endPosition, span->formatType);
+  }
+
+  return fclose(spansFile) == 0;
+}
+
+void freeFormatSpans(formatSpanTable *spans) {
+  free(spans->spans);
+  free(spans->tokens);
+  spans->spans = NULL;
+  spans->tokens = NULL;
+  spans->size = 0;
+  spans->count = 0;
+  spans->tokenSize = 0;
+  spans->tokenCount = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void initSections(sectionTable *sections) {
+  sections->size = SECTIONTABLESIZE;
+  sections->count = 0;
+  sections->tokenSize = SECTIONTABLESIZE;
+  sections->tokenCount = 0;
+  sections->headingSize = SECTIONTABLESIZE;
+  sections->headingCount = 0;
+  sections->nodeStartByte = 0;
+  sections->headingLines = malloc(sizeof(unsigned int) * sections->headingSize);
+  sections->headingBytes = malloc(sizeof(unsigned long long) * sections->headingSize);
+  sections->sections = malloc(sizeof(section) * sections->size);
+  sections->tokens = malloc(sizeof(sectionToken) * sections->tokenSize);
+}
+
+void addHeadingLine(sectionTable *sections, const unsigned int lineNum, const unsigned long long inputPosition) {
+  if (sections->headingCount == sections->headingSize) {
+    sections->headingSize *= 2;
+    sections->headingLines = (unsigned int*) realloc(sections->headingLines, sizeof(unsigned int) * sections->headingSize);
+    sections->headingBytes = (unsigned long long*) realloc(sections->headingBytes, sizeof(unsigned long long) * sections->headingSize);
+  }
+
+  sections->headingLines[sections->headingCount] = lineNum;
+  sections->headingBytes[sections->headingCount] = inputPosition;
+  ++sections->headingCount;
+}
+
+/*
+  NOTE: "data" is set for the tokens of the node itself, which make up the
+        title of a heading, wikitags by their target. Children of wikitags
+        only count for the first and last token of a section.
+*/
+static inline void addSectionToken(sectionTable *sections, const unsigned int lineNum, const unsigned int position, const short dataFormatType, const short ownFormatType, const unsigned int spacesCount, const char *data) {
+  sectionToken *token = NULL;
+
+  if (sections->tokenCount == sections->tokenSize) {
+    sections->tokenSize *= 2;
+    sections->tokens = (sectionToken*) realloc(sections->tokens, sizeof(sectionToken) * sections->tokenSize);
+  }
+
+  token = &sections->tokens[sections->tokenCount++];
+  token->lineNum = lineNum;
+  token->position = position;
+  token->formatType = dataFormatType != -1 ? dataFormatType : ownFormatType;
+  token->spacesCount = spacesCount;
+  token->data = data;
+}
+
+/*
+  NOTE: Called once the text node of a page is closed. A line starting with
+        '=' is a heading if its first token has a heading format, the level
+        follows from the format, "==" is level 2. A section ends before the
+        next heading of the same or a lower level, the last section of the
+        node ends with the closing line of the node.
+*/
+void addNodeSections(sectionTable *sections, const xmlNode *xmlTag, const parserBaseStore *parserRunTimeData) {
+  const xmlDataCollection *xmlCollection = parserRunTimeData->xmlCollection;
+  const unsigned int pageId = xmlCollection->pages[xmlCollection->pageCount - 1].pageId;
+  const unsigned int firstSection = sections->count;
+  unsigned int number = 0;
+  unsigned int tokenIndex = 0;
+  unsigned int titleLength = 0;
+  section *pageSection = NULL;
+
+  sections->tokenCount = 0;
+
+  for (unsigned int i = 0; i < xmlTag->wordCount; ++i) {
+    const word *wordElement = &xmlTag->words[i];
+    addSectionToken(sections, wordElement->lineNum, wordElement->position, wordElement->dataFormatType, wordElement->ownFormatType, wordElement->spacesCount, wordElement->data);
+  }
+
+  for (unsigned int i = 0; i < xmlTag->entityCount; ++i) {
+    const entity *entityElement = &xmlTag->entities[i];
+    addSectionToken(sections, entityElement->lineNum, entityElement->position, entityElement->dataFormatType, entityElement->ownFormatType, entityElement->spacesCount, entityElement->data);
+  }
+
+  for (unsigned int i = 0; i < xmlTag->wTagCount; ++i) {
+    const wikiTag *wTag = &xmlTag->wikiTags[i];
+    addSectionToken(sections, wTag->lineNum, wTag->position, wTag->dataFormatType, wTag->ownFormatType, wTag->spacesCount, parserRunTimeData->targets->data[wTag->target]);
+    addTagSectionTokens(sections, wTag);
+  }
+
+  if (sections->tokenCount == 0) {
+    sections->headingCount = 0;
+    return;
+  }
+
+  qsort(sections->tokens, sections->tokenCount, sizeof(sectionToken), compareSectionTokens);
+
+  // Lead section, the tokens before the first heading
+  if (sections->headingCount == 0 || sections->tokens[0].lineNum < sections->headingLines[0]) {
+    addSection(sections, pageId, 1, &sections->tokens[0], sections->nodeStartByte);
+    ++number;
+  }
+
+  for (unsigned int i = 0; i < sections->headingCount; ++i) {
+    const unsigned int lineNum = sections->headingLines[i];
+    const sectionToken *token = NULL;
+
+    tokenIndex = findSectionToken(sections, lineNum);
+    if (tokenIndex == sections->tokenCount) continue;
+
+    token = &sections->tokens[tokenIndex];
+    if (token->lineNum != lineNum || token->data == NULL || token->formatType < HEADINGFORMAT || token->formatType >= FORMATS) continue;
+
+    pageSection = addSection(sections, pageId, HEADINGFORMAT + 6 - token->formatType, token, sections->headingBytes[i]);
+    pageSection->number = number++;
+
+    // NOTE: The title is made of the tokens of the node on the heading line, separated by a space where the text had one
+    titleLength = 0;
+    for (unsigned int k = tokenIndex; k < sections->tokenCount && sections->tokens[k].lineNum == lineNum; ++k) {
+      if (sections->tokens[k].data != NULL) titleLength += strlen(sections->tokens[k].data) + 1;
+    }
+
+    pageSection->title = malloc(sizeof(char) * (titleLength + 1));
+    pageSection->title[0] = '\0';
+    titleLength = 0;
+    for (unsigned int k = tokenIndex; k < sections->tokenCount && sections->tokens[k].lineNum == lineNum; ++k) {
+      if (sections->tokens[k].data == NULL) continue;
+      strcpy(&pageSection->title[titleLength], sections->tokens[k].data);
+      titleLength += strlen(sections->tokens[k].data);
+      if (sections->tokens[k].spacesCount != 0) pageSection->title[titleLength++] = ' ';
+    }
+    while (titleLength != 0 && pageSection->title[titleLength - 1] == ' ') --titleLength;
+    pageSection->title[titleLength] = '\0';
+  }
+
+  /*
+    NOTE: Each section ends before the next one of the same or a lower level,
+          the parent is the section before of a lower level.
+  */
+  for (unsigned int i = firstSection; i < sections->count; ++i) {
+    section *current = &sections->sections[i];
+    const bool isLead = current->title == NULL;
+    unsigned int next = i + 1;
+
+    while (!isLead && next < sections->count && sections->sections[next].level > current->level) ++next;
+
+    if (next < sections->count) {
+      tokenIndex = findSectionToken(sections, sections->sections[next].firstLine);
+      current->endByte = sections->sections[next].startByte;
+    } else {
+      tokenIndex = sections->tokenCount;
+      current->endByte = parserRunTimeData->lineEndPosition;
+    }
+
+    if (tokenIndex != 0) {
+      current->lastLine = sections->tokens[tokenIndex - 1].lineNum;
+      current->lastPosition = sections->tokens[tokenIndex - 1].position;
+    }
+
+    current->parent = -1;
+    for (unsigned int k = i; k > firstSection && !isLead; --k) {
+      if (sections->sections[k - 1].title != NULL && sections->sections[k - 1].level < current->level) {
+        current->parent = sections->sections[k - 1].number;
+        break;
+      }
+    }
+  }
+
+  sections->headingCount = 0;
+}
+
+void addTagSectionTokens(sectionTable *sections, const wikiTag *wTag) {
+  wikiTag wikiTagElement;
+  unsigned int position = 0;
+  unsigned int lineNum = 0;
+
+  for (unsigned int i = 0; i < wTag->wordCount; ++i) {
+    position = wTag->pipedWords[i].position;
+    lineNum = wTag->pipedWords[i].lineNum;
+    shiftSharedChild(wTag, &position, &lineNum);
+    addSectionToken(sections, lineNum, position, -1, -1, 0, NULL);
+  }
+
+  for (unsigned int i = 0; i < wTag->entityCount; ++i) {
+    position = wTag->pipedEntities[i].position;
+    lineNum = wTag->pipedEntities[i].lineNum;
+    shiftSharedChild(wTag, &position, &lineNum);
+    addSectionToken(sections, lineNum, position, -1, -1, 0, NULL);
+  }
+
+  for (unsigned int i = 0; i < wTag->wTagCount; ++i) {
+    wikiTagElement = wTag->pipedTags[i];
+    shiftSharedChild(wTag, &wikiTagElement.position, &wikiTagElement.lineNum);
+    addSectionToken(sections, wikiTagElement.lineNum, wikiTagElement.position, -1, -1, 0, NULL);
+    addTagSectionTokens(sections, &wikiTagElement);
+  }
+}
+
+// NOTE: The section starts with "token", the lead section has no title
+section* addSection(sectionTable *sections, const unsigned int pageId, const unsigned short level, const sectionToken *token, const unsigned long long startByte) {
+  section *pageSection = NULL;
+
+  if (sections->count == sections->size) {
+    sections->size *= 2;
+    sections->sections = (section*) realloc(sections->sections, sizeof(section) * sections->size);
+  }
+
+  pageSection = &sections->sections[sections->count++];
+  pageSection->pageId = pageId;
+  pageSection->number = 0;
+  pageSection->parent = -1;
+  pageSection->level = level;
+  pageSection->firstLine = token->lineNum;
+  pageSection->firstPosition = token->position;
+  pageSection->lastLine = token->lineNum;
+  pageSection->lastPosition = token->position;
+  pageSection->startByte = startByte;
+  pageSection->endByte = startByte;
+  pageSection->title = NULL;
+  return pageSection;
+}
+
+// Index of the first token on or after the line, the token count if there is none
+unsigned int findSectionToken(const sectionTable *sections, const unsigned int lineNum) {
+  unsigned int low = 0;
+  unsigned int high = sections->tokenCount;
+
+  while (low < high) {
+    const unsigned int middle = low + (high - low) / 2;
+    if (sections->tokens[middle].lineNum < lineNum) low = middle + 1;
+    else high = middle;
+  }
+
+  return low;
+}
+
+int compareSectionTokens(const void *a, const void *b) {
+  const sectionToken *tokenA = (const sectionToken*) a;
+  const sectionToken *tokenB = (const sectionToken*) b;
+
+  if (tokenA->lineNum != tokenB->lineNum) return tokenA->lineNum < tokenB->lineNum ? -1 : 1;
+  if (tokenA->position != tokenB->position) return tokenA->position < tokenB->position ? -1 : 1;
+  return 0;
+}
+
+/*
+  NOTE: One row per section, "page id, number, parent, level, first line,
+        first position, last line, last position, start byte, end byte, title"
+*/
+bool writeOutSections(const sectionTable *sections) {
+  FILE *sectionsFile = fopen(SECTIONINDEXFILE, "w");
+  if (sectionsFile == NULL) return false;
+
+  for (unsigned int i = 0; i < sections->count; ++i) {
+    const section *pageSection = &sections->sections[i];
+    fprintf(sectionsFile, "%u\t%u\t%d\t%u\t%u\t%u\t%u\t%u\t%llu\t%llu\t%s\n", pageSection->pageId, pageSection->number, pageSection->parent, pageSection->level, pageSection->firstLine, pageSection->firstPosition, pageSection->lastLine, pageSection->lastPosition, pageSection->startByte, pageSection->endByte, pageSection->title == NULL ? "" : pageSection->title);
+  }
+
+  return fclose(sectionsFile) == 0;
+}
+
+void freeSections(sectionTable *sections) {
+  for (unsigned int i = 0; i < sections->count; ++i) free(sections->sections[i].title);
+  free(sections->headingLines);
+  free(sections->headingBytes);
+  free(sections->sections);
+  free(sections->tokens);
+  sections->headingLines = NULL;
+  sections->headingBytes = NULL;
+  sections->sections = NULL;
+  sections->tokens = NULL;
+  sections->size = 0;
+  sections->count = 0;
+  sections->tokenSize = 0;
+  sections->headingSize = 0;
+  sections->headingCount = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void initParameters(parameterTable *parameters) {
+  parameters->size = PARAMETERTABLESIZE;
+  parameters->count = 0;
+  parameters->parameters = malloc(sizeof(templateParameter) * parameters->size);
+  initTargets(&parameters->keys);
+}
+
+/*
+  NOTE: Splits the data of the template at the pipes outside of nested
+        templates and wikitags, the first part is the name of the template.
+        A parameter is named by the text before its first '=' outside of
+        nested ones, "{{cite web|url=a|b}}" has the key "url" and the key "1".
+*/
+void addTemplateParameters(parameterTable *parameters, const wikiTag *tag, const char *readData, const unsigned int pageId) {
+  const unsigned int dataLength = strlen(readData);
+  char keyData[dataLength + 1];
+  char positionData[8];
+  unsigned int start = 0;
+  unsigned int keyEnd = 0;
+  unsigned short depth = 0;
+  unsigned short index = 0;
+  unsigned short positionCount = 0;
+
+  for (unsigned int readerPos = 0; readerPos <= dataLength; ++readerPos) {
+    const char readIn = readData[readerPos];
+
+    if ((readIn == '{' || readIn == '[') && readData[readerPos + 1] == readIn) {
+      ++depth;
+      ++readerPos;
+      continue;
+    } else if ((readIn == '}' || readIn == ']') && readData[readerPos + 1] == readIn) {
+      if (depth != 0) --depth;
+      ++readerPos;
+      continue;
+    } else if (readIn == '=' && depth == 0 && keyEnd == 0 && index != 0) {
+      keyEnd = readerPos;
+      continue;
+    } else if (readIn != '\0' && (readIn != '|' || depth != 0)) continue;
+
+    if (index != 0) {
+      if (keyEnd != 0 && copyParameterText(keyData, &readData[start], keyEnd - start) != 0) {
+        addParameter(parameters, tag, pageId, index, keyData, &readData[keyEnd + 1], readerPos - keyEnd - 1);
+      } else {
+        snprintf(positionData, 8, "%u", ++positionCount);
+        addParameter(parameters, tag, pageId, index, positionData, &readData[start], readerPos - start);
+      }
+    }
+
+    ++index;
+    start = readerPos + 1;
+    keyEnd = 0;
+  }
+}
+
+void addParameter(parameterTable *parameters, const wikiTag *tag, const unsigned int pageId, const unsigned short index, const char *key, const char *value, const unsigned int valueLength) {
+  templateParameter *parameter = NULL;
+
+  if (parameters->count == parameters->size) {
+    parameters->size *= 2;
+    parameters->parameters = (templateParameter*) realloc(parameters->parameters, sizeof(templateParameter) * parameters->size);
+  }
+
+  parameter = &parameters->parameters[parameters->count++];
+  parameter->pageId = pageId;
+  parameter->lineNum = tag->lineNum;
+  parameter->position = tag->position;
+  parameter->templateName = tag->target;
+  parameter->key = internTarget(&parameters->keys, key, -1);
+  parameter->index = index;
+  parameter->value = malloc(sizeof(char) * (valueLength + 1));
+  copyParameterText(parameter->value, value, valueLength);
+}
+
+// NOTE: Copies the text without leading and trailing whitespace and each inner run of it as one space
+unsigned int copyParameterText(char *destination, const char *data, const unsigned int dataLength) {
+  unsigned int writerPos = 0;
+  bool isSpace = false;
+
+  for (unsigned int readerPos = 0; readerPos < dataLength; ++readerPos) {
+    if (isspace((unsigned char) data[readerPos])) {
+      isSpace = writerPos != 0;
+      continue;
+    }
+
+    if (isSpace) destination[writerPos++] = ' ';
+    destination[writerPos++] = data[readerPos];
+    isSpace = false;
+  }
+
+  destination[writerPos] = '\0';
+  return writerPos;
+}
+
+/*
+  NOTE: One row per parameter, "page id, line, position, template, index, key,
+        value", the template is written by its id with TARGETIDS and else
+        without trailing whitespace.
+*/
+bool writeOutParameters(const parameterTable *parameters, const targetTable *targets) {
+  FILE *parametersFile = fopen(PARAMETERSFILE, "w");
+  if (parametersFile == NULL) return false;
+
+  for (unsigned int i = 0; i < parameters->count; ++i) {
+    const templateParameter *parameter = &parameters->parameters[i];
+
+    const char *templateName = targets->data[parameter->templateName];
+    unsigned int nameLength = strlen(templateName);
+
+    while (nameLength != 0 && isspace((unsigned char) templateName[nameLength - 1])) --nameLength;
+
+    fprintf(parametersFile, "%u\t%u\t%u\t", parameter->pageId, parameter->lineNum, parameter->position);
+    if (TARGETIDS) fprintf(parametersFile, "%u", parameter->templateName);
+    else fprintf(parametersFile, "%.*s", nameLength, templateName);
+    fprintf(parametersFile, "\t%u\t%s\t%s\n", parameter->index, parameters->keys.data[parameter->key], parameter->value);
+  }
+
+  return fclose(parametersFile) == 0;
+}
+
+void freeParameters(parameterTable *parameters) {
+  for (unsigned int i = 0; i < parameters->count; ++i) free(parameters->parameters[i].value);
+  free(parameters->parameters);
+  parameters->parameters = NULL;
+  parameters->size = 0;
+  parameters->count = 0;
+  freeTargets(&parameters->keys);
+}
+
+//------------------------------------------------------------------------------
+
+static inline bool isLineEnd(const char *data) {
+  return data[0] == '\0' || data[0] == '\n' || data[0] == '\r';
+}
+
+/*
+  NOTE: Fast path of PAGEMETADATA for the lines of the MediaWiki export schema
+        directly in a page, "<name>value</name>" of the title, namespace, ids,
+        timestamp and sha1 and the lines opening and closing revisions and
+        contributors. These are read into the metadata of the page without an
+        xml node, other lines return false and are parsed as before.
+*/
+bool readPageMetadata(const char *line, struct parserBaseStore *parserRunTimeData) {
+  const xmlDataCollection* xmlCollection = parserRunTimeData->xmlCollection;
+
+  if (xmlCollection->pageCount == 0 || xmlCollection->openNodeCount == 0) return false;
+  if (strcmp(xmlCollection->nodes[xmlCollection->openNodes[xmlCollection->openNodeCount - 1]].name, "page") != 0) return false;
+
+  return readMetadataLine(line, parserRunTimeData);
+}
+
+// NOTE: Reads a metadata line into the record of the last page, lines of pages left unparsed by INCREMENTAL as well
+bool readMetadataLine(const char *line, struct parserBaseStore *parserRunTimeData) {
+  xmlDataCollection* xmlCollection = parserRunTimeData->xmlCollection;
+  metadataTable *metadata = parserRunTimeData->metadata;
+  pageMetadata *record = NULL;
+  const char *name = &line[1];
+  const char *value = NULL;
+  unsigned int nameLength = 0;
+  unsigned int valueLength = 0;
+
+  if (metadata->count < xmlCollection->pageCount) {
+    if (xmlCollection->pageCount > metadata->size) {
+      metadata->size = metadata->size == 0 ? PAGEMETADATATABLESIZE : metadata->size * 2;
+      metadata->records = (pageMetadata*) realloc(metadata->records, sizeof(pageMetadata) * metadata->size);
+    }
+
+    memset(&metadata->records[metadata->count], 0, sizeof(pageMetadata) * (xmlCollection->pageCount - metadata->count));
+    metadata->count = xmlCollection->pageCount;
+    metadata->isRevision = false;
+    metadata->isContributor = false;
+  }
+  record = &metadata->records[xmlCollection->pageCount - 1];
+
+  if (name[0] == '/') {
+    if (strncmp(name, "/revision>", 10) == 0 && isLineEnd(&name[10])) metadata->isRevision = false;
+    else if (strncmp(name, "/contributor>", 13) == 0 && isLineEnd(&name[13])) metadata->isContributor = false;
+    else return false;
+    return true;
+  }
+
+  if (strncmp(name, "revision>", 9) == 0 && isLineEnd(&name[9])) {
+    metadata->isRevision = true;
+    metadata->isContributor = false;
+    record->parentId = 0;
+    record->contributorId = 0;
+    record->isMinor = false;
+    record->hasSha1 = false;
+    return true;
+  } else if (strncmp(name, "contributor>", 12) == 0 && isLineEnd(&name[12])) {
+    metadata->isContributor = true;
+    return true;
+  } else if ((strncmp(name, "minor />", 8) == 0 && isLineEnd(&name[8])) || (strncmp(name, "minor/>", 7) == 0 && isLineEnd(&name[7]))) {
+    record->isMinor = true;
+    return true;
+  }
+
+  nameLength = strcspn(name, "> /\r\n");
+  if (name[nameLength] != '>') return false;
+
+  value = &name[nameLength + 1];
+  valueLength = strcspn(value, "<\r\n");
+  if (value[valueLength] != '<' || value[valueLength + 1] != '/' || strncmp(&value[valueLength + 2], name, nameLength) != 0) return false;
+  if (value[valueLength + 2 + nameLength] != '>' || !isLineEnd(&value[valueLength + 3 + nameLength])) return false;
+
+  if (nameLength == 5 && strncmp(name, "title", 5) == 0) readPageTitle(value, parserRunTimeData);
+  else if (nameLength == 2 && strncmp(name, "ns", 2) == 0) record->namespaceKey = strtol(value, NULL, 10);
+  else if (nameLength == 8 && strncmp(name, "parentid", 8) == 0) record->parentId = strtoul(value, NULL, 10);
+  else if (nameLength == 9 && strncmp(name, "timestamp", 9) == 0) record->timestamp = parseTimestamp(value);
+  else if (nameLength == 4 && strncmp(name, "sha1", 4) == 0) record->hasSha1 = parseSha1(record->sha1, value, valueLength);
+  else if (nameLength == 2 && strncmp(name, "id", 2) == 0) {
+    if (metadata->isContributor) record->contributorId = strtoul(value, NULL, 10);
+    else if (metadata->isRevision) record->revisionId = strtoul(value, NULL, 10);
+    else if (parserRunTimeData->pageId == 0) {
+      parserRunTimeData->pageId = strtoul(value, NULL, 10);
+      xmlCollection->pages[xmlCollection->pageCount - 1].pageId = parserRunTimeData->pageId;
+    }
+  } else return false;
+
+  return true;
+}
+
+// NOTE: Seconds since 1970 of "YYYY-MM-DDTHH:MM:SSZ" in UTC, 0 if not readable
+long long parseTimestamp(const char *data) {
+  int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+  long long era = 0;
+  unsigned int yearOfEra = 0;
+  unsigned int dayOfYear = 0;
+
+  if (sscanf(data, "%4d-%2d-%2dT%2d:%2d:%2d", &year, &month, &day, &hour, &minute, &second) != 6) return 0;
+
+  // NOTE: Days from the civil date, the years start in March so the leap day is the last one
+  year -= month <= 2;
+  era = (year >= 0 ? year : year - 399) / 400;
+  yearOfEra = year - era * 400;
+  dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+
+  return (era * 146097 + yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear - 719468) * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+// NOTE: The sha1 of the dump is base 36, it is read into its 20 bytes, big endian
+bool parseSha1(unsigned char *sha1, const char *data, const unsigned int dataLength) {
+  unsigned int carry = 0;
+  unsigned int digit = 0;
+
+  memset(sha1, 0, WICKEDSHA1SIZE);
+  if (dataLength == 0) return false;
+
+  for (unsigned int i = 0; i < dataLength; ++i) {
+    if (data[i] >= '0' && data[i] <= '9') digit = data[i] - '0';
+    else if (data[i] >= 'a' && data[i] <= 'z') digit = data[i] - 'a' + 10;
+    else return false;
+
+    carry = digit;
+    for (int k = WICKEDSHA1SIZE - 1; k >= 0; --k) {
+      carry += sha1[k] * 36;
+      sha1[k] = carry & 0xFF;
+      carry >>= 8;
+    }
+    if (carry != 0) return false;
+  }
+
+  return true;
+}
+
+// NOTE: Writes the columns described in wickedbinary.h, pages without metadata lines have zeros
+bool writeOutMetadata(const metadataTable *metadata, const xmlDataCollection *xmlCollection) {
+  FILE *metadataFile = fopen(METADATAFILE, "wb");
+  const pageMetadata emptyRecord = {0};
+  const pageMetadata *record = NULL;
+
+  if (metadataFile == NULL) return false;
+
+  fwrite(WICKEDMETADATAMAGIC, 1, 4, metadataFile);
+  writeBinaryUnsigned(metadataFile, WICKEDMETADATAVERSION, 4);
+  writeBinaryUnsigned(metadataFile, xmlCollection->pageCount, 4);
+  writeBinaryUnsigned(metadataFile, 0, 4);
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) {
+    record = i < metadata->count ? &metadata->records[i] : &emptyRecord;
+    writeBinaryUnsigned(metadataFile, record->timestamp, 8);
+  }
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) writeBinaryUnsigned(metadataFile, xmlCollection->pages[i].pageId, 4);
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) {
+    record = i < metadata->count ? &metadata->records[i] : &emptyRecord;
+    writeBinaryUnsigned(metadataFile, record->revisionId, 4);
+  }
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) {
+    record = i < metadata->count ? &metadata->records[i] : &emptyRecord;
+    writeBinaryUnsigned(metadataFile, record->parentId, 4);
+  }
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) {
+    record = i < metadata->count ? &metadata->records[i] : &emptyRecord;
+    writeBinaryUnsigned(metadataFile, record->contributorId, 4);
+  }
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) {
+    record = i < metadata->count ? &metadata->records[i] : &emptyRecord;
+    writeBinaryUnsigned(metadataFile, record->namespaceKey, 2);
+  }
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) {
+    record = i < metadata->count ? &metadata->records[i] : &emptyRecord;
+    fwrite(record->sha1, 1, WICKEDSHA1SIZE, metadataFile);
+  }
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) {
+    record = i < metadata->count ? &metadata->records[i] : &emptyRecord;
+    fputc((record->isMinor ? WICKEDMETADATAMINOR : 0) | (record->hasSha1 ? WICKEDMETADATASHA1 : 0), metadataFile);
+  }
+
+  return fclose(metadataFile) == 0;
+}
+
+void freeMetadata(metadataTable *metadata) {
+  free(metadata->records);
+  metadata->records = NULL;
+  metadata->size = 0;
+  metadata->count = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void initRevisionDeltas(revisionDeltas *deltas, FILE *deltasFile) {
+  deltas->deltasFile = deltasFile;
+  deltas->pageRecord = 0;
+  deltas->pageRevisions = 0;
+  deltas->revisionCount = 0;
+  deltas->hashCount = 0;
+  deltas->hashSize = REVISIONTOKENSIZE;
+  deltas->tokenCount = 0;
+  deltas->tokenSize = REVISIONTOKENSIZE;
+  deltas->editCount = 0;
+  deltas->editSize = REVISIONTOKENSIZE;
+  deltas->traceSize = 0;
+  deltas->hashes = malloc(sizeof(unsigned int) * deltas->hashSize);
+  deltas->tokens = malloc(sizeof(revisionToken) * deltas->tokenSize);
+  deltas->edits = malloc(sizeof(revisionEdit) * deltas->editSize);
+  deltas->trace = NULL;
+}
+
+// NOTE: Tokens are compared by the hash of their data, wikitags by their type and target
+static inline void addRevisionToken(revisionDeltas *deltas, const unsigned int lineNum, const unsigned int position, const unsigned int hash, const char *data) {
+  revisionToken *token = NULL;
+
+  if (deltas->tokenCount == deltas->tokenSize) {
+    deltas->tokenSize *= 2;
+    deltas->tokens = (revisionToken*) realloc(deltas->tokens, sizeof(revisionToken) * deltas->tokenSize);
+  }
+
+  token = &deltas->tokens[deltas->tokenCount++];
+  token->lineNum = lineNum;
+  token->position = position;
+  token->hash = hash;
+  token->data = data;
+}
+
+/*
+  NOTE: Called once the text of a page is closed. The first text of a page is
+        kept as it is, each following one is written as the edit script
+        against the text before and its tokens are freed. Rows of
+        REVISIONDELTASFILE:
+        "R page id, revision, line, tokens, kept, deleted, inserted" per text
+        "=\tcount" tokens kept, "-\tcount" tokens deleted, "+\tdata" a token inserted
+*/
+void addRevisionDelta(revisionDeltas *deltas, xmlNode *xmlTag, const parserBaseStore *parserRunTimeData) {
+  const xmlDataCollection *xmlCollection = parserRunTimeData->xmlCollection;
+  const targetTable *targets = parserRunTimeData->targets;
+  const bool isFirst = deltas->pageRecord != xmlCollection->pageCount;
+  unsigned int keptCount = 0;
+  unsigned int deletedCount = 0;
+  unsigned int insertedCount = 0;
+
+  deltas->tokenCount = 0;
+
+  for (unsigned int i = 0; i < xmlTag->wordCount; ++i) {
+    addRevisionToken(deltas, xmlTag->words[i].lineNum, xmlTag->words[i].position, hashWord(xmlTag->words[i].data), xmlTag->words[i].data);
+  }
+
+  for (unsigned int i = 0; i < xmlTag->entityCount; ++i) {
+    addRevisionToken(deltas, xmlTag->entities[i].lineNum, xmlTag->entities[i].position, hashWord(xmlTag->entities[i].data), xmlTag->entities[i].data);
+  }
+
+  for (unsigned int i = 0; i < xmlTag->wTagCount; ++i) {
+    const wikiTag *wTag = &xmlTag->wikiTags[i];
+    addRevisionToken(deltas, wTag->lineNum, wTag->position, hashValue(hashWord(targets->data[wTag->target]), wTag->tagType), targets->data[wTag->target]);
+    addRevisionTagTokens(deltas, wTag, targets);
+  }
+
+  qsort(deltas->tokens, deltas->tokenCount, sizeof(revisionToken), compareRevisionTokens);
+
+  if (isFirst) {
+    deltas->pageRecord = xmlCollection->pageCount;
+    deltas->pageRevisions = 0;
+    deltas->hashCount = 0;
+  }
+
+  diffRevisionTokens(deltas);
+
+  for (unsigned int i = 0; i < deltas->editCount; ++i) {
+    if (deltas->edits[i].type == '=') keptCount += deltas->edits[i].count;
+    else if (deltas->edits[i].type == '-') deletedCount += deltas->edits[i].count;
+    else insertedCount += deltas->edits[i].count;
+  }
+
+  if (deltas->deltasFile != NULL) {
+    fprintf(deltas->deltasFile, "R\t%u\t%u\t%u\t%u\t%u\t%u\t%u\n", xmlCollection->pages[xmlCollection->pageCount - 1].pageId, deltas->pageRevisions, xmlTag->start, deltas->tokenCount, keptCount, deletedCount, insertedCount);
+
+    for (unsigned int i = 0; i < deltas->editCount && !isFirst; ++i) {
+      const revisionEdit *edit = &deltas->edits[i];
+
+      if (edit->type != '+') fprintf(deltas->deltasFile, "%c\t%u\n", edit->type, edit->count);
+      else for (unsigned int k = edit->token; k < edit->token + edit->count; ++k) fprintf(deltas->deltasFile, "+\t%s\n", deltas->tokens[k].data);
+    }
+  }
+
+  // NOTE: The stream of this text is the one the next text is compared to
+  if (deltas->tokenCount > deltas->hashSize) {
+    while (deltas->tokenCount > deltas->hashSize) deltas->hashSize *= 2;
+    deltas->hashes = (unsigned int*) realloc(deltas->hashes, sizeof(unsigned int) * deltas->hashSize);
+  }
+
+  for (unsigned int i = 0; i < deltas->tokenCount; ++i) deltas->hashes[i] = deltas->tokens[i].hash;
+  deltas->hashCount = deltas->tokenCount;
+
+  if (!isFirst) freeXMLNodeTokens(xmlTag);
+
+  ++deltas->pageRevisions;
+  ++deltas->revisionCount;
+}
+
+void addRevisionTagTokens(revisionDeltas *deltas, const wikiTag *wTag, const targetTable *targets) {
+  wikiTag wikiTagElement;
+  unsigned int position = 0;
+  unsigned int lineNum = 0;
+
+  for (unsigned int i = 0; i < wTag->wordCount; ++i) {
+    position = wTag->pipedWords[i].position;
+    lineNum = wTag->pipedWords[i].lineNum;
+    shiftSharedChild(wTag, &position, &lineNum);
+    addRevisionToken(deltas, lineNum, position, hashWord(wTag->pipedWords[i].data), wTag->pipedWords[i].data);
+  }
+
+  for (unsigned int i = 0; i < wTag->entityCount; ++i) {
+    position = wTag->pipedEntities[i].position;
+    lineNum = wTag->pipedEntities[i].lineNum;
+    shiftSharedChild(wTag, &position, &lineNum);
+    addRevisionToken(deltas, lineNum, position, hashWord(wTag->pipedEntities[i].data), wTag->pipedEntities[i].data);
+  }
+
+  for (unsigned int i = 0; i < wTag->wTagCount; ++i) {
+    wikiTagElement = wTag->pipedTags[i];
+    shiftSharedChild(wTag, &wikiTagElement.position, &wikiTagElement.lineNum);
+    addRevisionToken(deltas, wikiTagElement.lineNum, wikiTagElement.position, hashValue(hashWord(targets->data[wikiTagElement.target]), wikiTagElement.tagType), targets->data[wikiTagElement.target]);
+    addRevisionTagTokens(deltas, &wikiTagElement, targets);
+  }
+}
+
+/*
+  NOTE: Edit script from "hashes" to the hashes of "tokens". The common start
+        and end are kept as they are, the middle is compared by the greedy
+        algorithm of Myers. Middles needing more than REVISIONDIFFLIMIT edits
+        are deleted and inserted as a whole.
+*/
+void diffRevisionTokens(revisionDeltas *deltas) {
+  const unsigned int oldCount = deltas->hashCount;
+  const unsigned int newCount = deltas->tokenCount;
+  unsigned int prefix = 0;
+  unsigned int suffix = 0;
+
+  deltas->editCount = 0;
+
+  while (prefix < oldCount && prefix < newCount && deltas->hashes[prefix] == deltas->tokens[prefix].hash) ++prefix;
+  while (suffix < oldCount - prefix && suffix < newCount - prefix && deltas->hashes[oldCount - 1 - suffix] == deltas->tokens[newCount - 1 - suffix].hash) ++suffix;
+
+  addRevisionEdit(deltas, '=', prefix, 0);
+
+  if (!diffRevisionMiddle(deltas, prefix, oldCount - suffix, newCount - suffix)) {
+    addRevisionEdit(deltas, '-', oldCount - prefix - suffix, 0);
+    addRevisionEdit(deltas, '+', newCount - prefix - suffix, prefix);
+  }
+
+  addRevisionEdit(deltas, '=', suffix, 0);
+}
+
+/*
+  NOTE: "trace" holds the furthest reaching old position of each diagonal k
+        for each count of edits d, the script is found back from the end.
+        Old tokens run from "start" to "oldEnd", new ones to "newEnd".
+*/
+bool diffRevisionMiddle(revisionDeltas *deltas, const unsigned int start, const unsigned int oldEnd, const unsigned int newEnd) {
+  const int oldCount = oldEnd - start;
+  const int newCount = newEnd - start;
+  const int limit = oldCount + newCount < REVISIONDIFFLIMIT ? oldCount + newCount : REVISIONDIFFLIMIT;
+  const int width = 2 * limit + 3;
+  const unsigned int firstEdit = deltas->editCount;
+  int *furthest = NULL;
+  int editCount = -1;
+  int x = 0;
+  int y = 0;
+
+  if (oldCount == 0 || newCount == 0) return false;
+
+  for (int d = 0; d <= limit && editCount == -1; ++d) {
+    if ((unsigned int) ((d + 1) * width) > deltas->traceSize) {
+      deltas->traceSize = (d + 1) * width * 2;
+      deltas->trace = (int*) realloc(deltas->trace, sizeof(int) * deltas->traceSize);
+    }
+
+    furthest = &deltas->trace[d * width + limit + 1];
+    if (d == 0) furthest[1] = 0;
+    else memcpy(&furthest[-limit - 1], &deltas->trace[(d - 1) * width], sizeof(int) * width);
+
+    for (int k = -d; k <= d; k += 2) {
+      if (k == -d || (k != d && furthest[k - 1] < furthest[k + 1])) x = furthest[k + 1];
+      else x = furthest[k - 1] + 1;
+      y = x - k;
+
+      while (x < oldCount && y < newCount && deltas->hashes[start + x] == deltas->tokens[start + y].hash) {
+        ++x;
+        ++y;
+      }
+
+      furthest[k] = x;
+      if (x >= oldCount && y >= newCount) {
+        editCount = d;
+        break;
+      }
+    }
+  }
+
+  if (editCount == -1) return false;
+
+  // NOTE: The edits are found from the end, they are added reversed and turned around after
+  x = oldCount;
+  y = newCount;
+  for (int d = editCount; d > 0; --d) {
+    const int *before = &deltas->trace[(d - 1) * width + limit + 1];
+    const int k = x - y;
+    const int beforeK = (k == -d || (k != d && before[k - 1] < before[k + 1])) ? k + 1 : k - 1;
+    const int beforeX = before[beforeK];
+    const int beforeY = beforeX - beforeK;
+
+    while (x > beforeX && y > beforeY) {
+      addRevisionEdit(deltas, '=', 1, 0);
+      --x;
+      --y;
+    }
+
+    if (x == beforeX) addRevisionEdit(deltas, '+', 1, start + --y);
+    else {
+      addRevisionEdit(deltas, '-', 1, 0);
+      --x;
+    }
+  }
+
+  if (x > 0) addRevisionEdit(deltas, '=', x, 0);
+
+  for (unsigned int i = firstEdit, k = deltas->editCount; i + 1 < k; ++i, --k) {
+    const revisionEdit edit = deltas->edits[i];
+    deltas->edits[i] = deltas->edits[k - 1];
+    deltas->edits[k - 1] = edit;
+  }
+
+  return true;
+}
+
+// NOTE: Runs of the same edit are one edit, inserted tokens only if they follow each other
+void addRevisionEdit(revisionDeltas *deltas, const char type, const unsigned int count, const unsigned int token) {
+  revisionEdit *edit = deltas->editCount != 0 ? &deltas->edits[deltas->editCount - 1] : NULL;
+
+  if (count == 0) return;
+
+  if (edit != NULL && edit->type == type && (type != '+' || edit->token + edit->count == token || token + count == edit->token)) {
+    if (type == '+' && token < edit->token) edit->token = token;
+    edit->count += count;
+    return;
+  }
+
+  if (deltas->editCount == deltas->editSize) {
+    deltas->editSize *= 2;
+    deltas->edits = (revisionEdit*) realloc(deltas->edits, sizeof(revisionEdit) * deltas->editSize);
+  }
+
+  edit = &deltas->edits[deltas->editCount++];
+  edit->type = type;
+  edit->count = count;
+  edit->token = token;
+}
+
+int compareRevisionTokens(const void *a, const void *b) {
+  const revisionToken *tokenA = (const revisionToken*) a;
+  const revisionToken *tokenB = (const revisionToken*) b;
+
+  if (tokenA->lineNum != tokenB->lineNum) return tokenA->lineNum < tokenB->lineNum ? -1 : 1;
+  if (tokenA->position != tokenB->position) return tokenA->position < tokenB->position ? -1 : 1;
+  return 0;
+}
+
+void freeRevisionDeltas(revisionDeltas *deltas) {
+  if (deltas->deltasFile != NULL) fclose(deltas->deltasFile);
+  free(deltas->hashes);
+  free(deltas->tokens);
+  free(deltas->edits);
+  free(deltas->trace);
+  deltas->deltasFile = NULL;
+  deltas->hashes = NULL;
+  deltas->tokens = NULL;
+  deltas->edits = NULL;
+  deltas->trace = NULL;
+  deltas->hashSize = 0;
+  deltas->tokenSize = 0;
+  deltas->editSize = 0;
+  deltas->traceSize = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void initIncremental(incrementalRun *incremental) {
+  incremental->keyCount = 0;
+  incremental->keySize = INCREMENTALTABLESIZE;
+  incremental->previousCount = 0;
+  incremental->reusedCount = 0;
+  incremental->reusedSize = INCREMENTALTABLESIZE;
+  incremental->linesLength = 0;
+  incremental->linesSize = INCREMENTALLINEBUFFER;
+  incremental->lineSize = 0;
+  incremental->line = NULL;
+  incremental->lines = malloc(sizeof(char) * incremental->linesSize);
+  incremental->keys = calloc(incremental->keySize, sizeof(pageKey));
+  incremental->previous = NULL;
+  incremental->reused = malloc(sizeof(reusedPage) * incremental->reusedSize);
+
+  for (unsigned short i = 0; i < OUTPUTFILES; ++i) incremental->previousFiles[i] = -1;
+}
+
+/*
+  NOTE: Reads REVISIONMANIFESTFILE of the previous run in PREVIOUSDIRECTORY and
+        opens its files. The files of the manifest have to be the files of this
+        run, otherwise all pages are parsed.
+*/
+bool readPreviousRun(incrementalRun *incremental, outputBuffer **outputs) {
+  char path[FILENAMELENGTH];
+  char header[FILENAMELENGTH * (OUTPUTFILES + 1)];
+  FILE *manifestFile = NULL;
+  unsigned int headerLength = 0;
+  unsigned int previousSize = INCREMENTALTABLESIZE;
+  ssize_t lineLength = 0;
+  bool isRead = true;
+
+  snprintf(path, FILENAMELENGTH, "%s/%s", PREVIOUSDIRECTORY, REVISIONMANIFESTFILE);
+  manifestFile = fopen(path, "r");
+  if (manifestFile == NULL) return false;
+
+  headerLength = revisionManifestHeader(header, sizeof(header), outputs);
+
+  lineLength = getline(&incremental->line, &incremental->lineSize, manifestFile);
+  if (lineLength <= 0 || strncmp(incremental->line, header, headerLength) != 0 || !isLineEnd(&incremental->line[headerLength])) {
+    printf("[ ERROR ] The files or switches of \"%s\" are not the ones of this run.\n", path);
+    fclose(manifestFile);
+    return false;
+  }
+
+  incremental->previous = malloc(sizeof(previousPage) * previousSize);
+  while (isRead && (lineLength = getline(&incremental->line, &incremental->lineSize, manifestFile)) > 0) {
+    previousPage *previous = NULL;
+    char *field = incremental->line;
+
+    if (incremental->previousCount == previousSize) {
+      previousSize *= 2;
+      incremental->previous = (previousPage*) realloc(incremental->previous, sizeof(previousPage) * previousSize);
+    }
+
+    previous = &incremental->previous[incremental->previousCount];
+    previous->key.pageId = strtoul(field, &field, 10);
+    previous->key.hasSha1 = field[0] == '\t' && field[1] != '-';
+    memset(previous->key.sha1, 0, WICKEDSHA1SIZE);
+
+    if (previous->key.hasSha1) {
+      for (unsigned short i = 0; i < WICKEDSHA1SIZE && isRead; ++i) isRead = sscanf(&field[1 + i * 2], "%2hhx", &previous->key.sha1[i]) == 1;
+      field += 1 + WICKEDSHA1SIZE * 2;
+    } else field += 2;
+
+    previous->key.hash = strtoul(field, &field, 16);
+    previous->startLine = strtoul(field, &field, 10);
+    previous->endLine = strtoul(field, &field, 10);
+
+    for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+      previous->startBytes[i] = strtoull(field, &field, 10);
+      previous->endBytes[i] = strtoull(field, &field, 10);
+    }
+
+    isRead = isRead && isLineEnd(field) && previous->endLine >= previous->startLine;
+    if (isRead) ++incremental->previousCount;
+  }
+  fclose(manifestFile);
+
+  for (unsigned short i = 0; i < OUTPUTFILES && isRead; ++i) {
+    snprintf(path, FILENAMELENGTH, "%s/%s", PREVIOUSDIRECTORY, outputs[i]->fileName);
+    incremental->previousFiles[i] = open(path, O_RDONLY);
+    isRead = incremental->previousFiles[i] != -1 || outputs[i]->fileDescriptor == -1;
+  }
+
+  if (!isRead) {
+    printf("[ ERROR ] Cannot read the previous run in \"%s\".\n", PREVIOUSDIRECTORY);
+    for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+      if (incremental->previousFiles[i] != -1) close(incremental->previousFiles[i]);
+      incremental->previousFiles[i] = -1;
+    }
+    incremental->previousCount = 0;
+    return false;
+  }
+
+  qsort(incremental->previous, incremental->previousCount, sizeof(previousPage), comparePreviousPages);
+  return true;
+}
+
+/*
+  NOTE: Called with each line starting with "<", pages start with a line of
+        "<page>" only. The page is read ahead up to "</page>" for its id, the
+        sha1 of its last revision and the hash of its lines outside the text.
+        A page of the same keys and lines in the previous run is not parsed,
+        its lines are taken over and its title and metadata read from the
+        lines kept. Other pages are read again from their start, false is
+        returned for them.
+*/
+bool skipUnchangedPage(const char *line, FILE *inputFile, incrementalRun *incremental, parserBaseStore *parserRunTimeData, unsigned long long *inputBytes) {
+  xmlDataCollection *xmlCollection = parserRunTimeData->xmlCollection;
+  const off_t startPosition = ftello(inputFile);
+  const unsigned int record = xmlCollection->pageCount;
+  const previousPage *previous = NULL;
+  pageKey *key = NULL;
+  char *readLine = NULL;
+  char *tagEnd = NULL;
+  unsigned int lineCount = 0;
+  unsigned int lineLength = 0;
+  ssize_t readLength = 0;
+  bool isText = false;
+  bool isPageEnd = false;
+
+  if (strncmp(line, "<page>", 6) != 0 || !isLineEnd(&line[6]) || startPosition == -1) return false;
+
+  if (record >= incremental->keySize) {
+    while (record >= incremental->keySize) incremental->keySize *= 2;
+    incremental->keys = (pageKey*) realloc(incremental->keys, sizeof(pageKey) * incremental->keySize);
+  }
+
+  if (record >= incremental->keyCount) {
+    memset(&incremental->keys[incremental->keyCount], 0, sizeof(pageKey) * (record + 1 - incremental->keyCount));
+    incremental->keyCount = record + 1;
+  }
+
+  key = &incremental->keys[record];
+  key->hash = 2166136261u;
+  incremental->linesLength = 0;
+
+  while (!isPageEnd && (readLength = getline(&incremental->line, &incremental->lineSize, inputFile)) > 0) {
+    readLine = &incremental->line[strspn(incremental->line, " \t")];
+    ++lineCount;
+
+    // NOTE: The text is left to the sha1, its tag may close itself or the text on the same line
+    if (isText) {
+      isText = strstr(readLine, "</text>") == NULL;
+      continue;
+    } else if (strncmp(readLine, "<text", 5) == 0 && (readLine[5] == ' ' || readLine[5] == '>')) {
+      tagEnd = strchr(readLine, '>');
+      isText = tagEnd != NULL && tagEnd[-1] != '/' && strstr(tagEnd, "</text>") == NULL;
+      continue;
+    }
+
+    key->hash = hashValue(key->hash, hashWord(readLine));
+    isPageEnd = strncmp(readLine, "</page>", 7) == 0;
+
+    if (strncmp(readLine, "<id>", 4) == 0 && key->pageId == 0) key->pageId = strtoul(&readLine[4], NULL, 10);
+    else if (strncmp(readLine, "<sha1>", 6) == 0) key->hasSha1 = parseSha1(key->sha1, &readLine[6], strcspn(&readLine[6], "<\r\n"));
+
+    if (isPageEnd) break;
+
+    lineLength = strlen(readLine) + 1;
+    if (incremental->linesLength + lineLength > incremental->linesSize) {
+      while (incremental->linesLength + lineLength > incremental->linesSize) incremental->linesSize *= 2;
+      incremental->lines = (char*) realloc(incremental->lines, sizeof(char) * incremental->linesSize);
+    }
+    memcpy(&incremental->lines[incremental->linesLength], readLine, lineLength);
+    incremental->linesLength += lineLength;
+  }
+
+  if (isPageEnd && key->hasSha1 && incremental->previousCount != 0) {
+    previous = bsearch(key, incremental->previous, incremental->previousCount, sizeof(previousPage), comparePreviousPages);
+  }
+
+  if (previous == NULL || !previous->key.hasSha1 || memcmp(previous->key.sha1, key->sha1, WICKEDSHA1SIZE) != 0 || previous->key.hash != key->hash || previous->endLine - previous->startLine != lineCount) {
+    fseeko(inputFile, startPosition, SEEK_SET);
+    return false;
+  }
+
+  addPage(parserRunTimeData);
+  parserRunTimeData->pageId = key->pageId;
+  xmlCollection->pages[record].pageId = key->pageId;
+
+  for (unsigned int readerPos = 0; readerPos < incremental->linesLength; readerPos += strlen(&incremental->lines[readerPos]) + 1) {
+    readLine = &incremental->lines[readerPos];
+    if (PAGEMETADATA && readLine[0] == '<') readMetadataLine(readLine, parserRunTimeData);
+    else if (strncmp(readLine, "<title>", 7) == 0) readPageTitle(&readLine[7], parserRunTimeData);
+  }
+
+  if (incremental->reusedCount == incremental->reusedSize) {
+    incremental->reusedSize *= 2;
+    incremental->reused = (reusedPage*) realloc(incremental->reused, sizeof(reusedPage) * incremental->reusedSize);
+  }
+  incremental->reused[incremental->reusedCount++] = (reusedPage) {record, previous - incremental->previous};
+
+  *inputBytes += ftello(inputFile) - startPosition;
+  parserRunTimeData->currentLine += lineCount;
+  xmlCollection->pages[record].endLine = parserRunTimeData->currentLine;
+  parserRunTimeData->isPageEnd = true;
+
+  return true;
+}
+
+// NOTE: The page key comes first in the previous pages, so keys are searched for as well
+int comparePreviousPages(const void *a, const void *b) {
+  const pageKey *pageA = (const pageKey*) a;
+  const pageKey *pageB = (const pageKey*) b;
+
+  if (pageA->pageId != pageB->pageId) return pageA->pageId < pageB->pageId ? -1 : 1;
+  return 0;
+}
+
+/*
+  NOTE: The header names the columns and ends with the switches which change
+        the rows of the files, a previous run is only used with the same header.
+*/
+unsigned int revisionManifestHeader(char *header, const unsigned int headerSize, outputBuffer **outputs) {
+  unsigned int headerLength = snprintf(header, headerSize, "# page id\tsha1\thash\tfirst line\tlast line");
+
+  for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+    headerLength += snprintf(&header[headerLength], headerSize - headerLength, "\tfirst byte %s\tend byte %s", outputs[i]->fileName, outputs[i]->fileName);
+  }
+
+  headerLength += snprintf(&header[headerLength], headerSize - headerLength, "\tswitches %d%d%d%d%d", SPLITPUNCTUATION, REDIRECTTABLE, NORMALIZETARGETS, FORMATSPANS, PAGEMETADATA);
+  return headerLength;
+}
+
+/*
+  NOTE: Rows of REVISIONMANIFESTFILE: page id, sha1 in hex or "-", hash, first
+        and last line and the first and end byte of the page in each file,
+        like the page index.
+*/
+bool writeOutRevisionManifest(const incrementalRun *incremental, outputBuffer **outputs, const xmlDataCollection *xmlCollection) {
+  FILE *manifestFile = fopen(REVISIONMANIFESTFILE, "w");
+  const pageKey emptyKey = {0};
+  char header[FILENAMELENGTH * (OUTPUTFILES + 1)];
+
+  if (manifestFile == NULL) return false;
+
+  revisionManifestHeader(header, sizeof(header), outputs);
+  fprintf(manifestFile, "%s\n", header);
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) {
+    const pageKey *key = i < incremental->keyCount ? &incremental->keys[i] : &emptyKey;
+
+    fprintf(manifestFile, "%u\t", xmlCollection->pages[i].pageId);
+    if (key->hasSha1) for (unsigned short j = 0; j < WICKEDSHA1SIZE; ++j) fprintf(manifestFile, "%02x", key->sha1[j]);
+    else fputc('-', manifestFile);
+    fprintf(manifestFile, "\t%x\t%u\t%u", key->hash, xmlCollection->pages[i].startLine, xmlCollection->pages[i].endLine);
+
+    for (unsigned short j = 0; j < OUTPUTFILES; ++j) {
+      fprintf(manifestFile, "\t%llu\t%llu", outputs[j]->pageOffsets[i], outputs[j]->pageOffsets[i + 1]);
+    }
+    fputc('\n', manifestFile);
+  }
+
+  return fclose(manifestFile) == 0;
+}
+
+void freeIncremental(incrementalRun *incremental) {
+  for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+    if (incremental->previousFiles[i] != -1) close(incremental->previousFiles[i]);
+    incremental->previousFiles[i] = -1;
+  }
+
+  free(incremental->line);
+  free(incremental->lines);
+  free(incremental->keys);
+  free(incremental->previous);
+  free(incremental->reused);
+  incremental->line = NULL;
+  incremental->lines = NULL;
+  incremental->keys = NULL;
+  incremental->previous = NULL;
+  incremental->reused = NULL;
+  incremental->keyCount = 0;
+  incremental->previousCount = 0;
+  incremental->reusedCount = 0;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Options of the page filters:
+        -n 0,14     namespace keys
+        -p prefix   title prefix, can be given more than once
+        -r regex    extended regular expression on the title
+        -i 10-200   page ids, "10-" and "-200" leave the range open
+        -c 100      first pages matching
+        Titles are matched as written in the dump, the namespace is the <ns>
+        of the page or else the one of the prefix of its title.
+*/
+bool readPageFilters(pageFilter *filter, int argc, char *argv[]) {
+  char *field = NULL;
+  int option = 0;
+
+  *filter = (pageFilter) {false, false, false, 0, 0, 0, UINT_MAX, 0, 0, 0, 0, NULL, NULL, NULL, NULL};
+
+  while ((option = getopt(argc, argv, "n:p:r:i:c:")) != -1) {
+    filter->isActive = true;
+
+    switch (option) {
+      case 'n':
+        for (field = optarg; *field != '\0'; field += *field == ',') {
+          filter->namespaces = (short*) realloc(filter->namespaces, sizeof(short) * (filter->namespaceCount + 1));
+          filter->namespaces[filter->namespaceCount++] = strtol(field, &field, 10);
+          if (*field != ',' && *field != '\0') return false;
+        }
+        break;
+      case 'p':
+        filter->prefixes = (const char**) realloc(filter->prefixes, sizeof(char*) * (filter->prefixCount + 1));
+        filter->prefixes[filter->prefixCount++] = optarg;
+        break;
+      case 'r':
+        if (filter->hasRegex) regfree(&filter->titleRegex);
+        filter->hasRegex = regcomp(&filter->titleRegex, optarg, REG_EXTENDED | REG_NOSUB) == 0;
+        if (!filter->hasRegex) return false;
+        break;
+      case 'i':
+        field = optarg;
+        filter->firstId = *field == '-' ? 0 : strtoul(field, &field, 10);
+        if (*field++ != '-') return false;
+        if (*field != '\0') filter->lastId = strtoul(field, &field, 10);
+        if (*field != '\0' || filter->firstId > filter->lastId) return false;
+        break;
+      case 'c':
+        filter->pageLimit = strtoul(optarg, &field, 10);
+        if (*field != '\0') return false;
+        break;
+      default:
+        return false;
+    }
+  }
+
+  return optind == argc;
+}
+
+/*
+  NOTE: Called with each line starting with "<", pages start with a line of
+        "<page>" only. The page is read ahead up to its id for the title and
+        namespace, a page matching the filters is read again from its start
+        and false is returned. Other pages are skipped line by line up to
+        "</page>", so the lines of the pages after keep their numbers.
+*/
+bool skipFilteredPage(const char *line, FILE *inputFile, pageFilter *filter, parserBaseStore *parserRunTimeData, unsigned long long *inputBytes) {
+  const off_t startPosition = ftello(inputFile);
+  namespaceEntry *entry = NULL;
+  char *readLine = NULL;
+  unsigned int lineCount = 0;
+  unsigned int pageId = 0;
+  unsigned int prefixLength = 0;
+  short namespaceKey = 0;
+  ssize_t readLength = 0;
+  bool hasNamespace = false;
+  bool isPageEnd = false;
+
+  if (strncmp(line, "<page>", 6) != 0 || !isLineEnd(&line[6]) || startPosition == -1) return false;
+
+  if (filter->pageLimit != 0 && filter->pageCount == filter->pageLimit) {
+    filter->isFinished = true;
+    return true;
+  }
+
+  if (filter->title != NULL) filter->title[0] = '\0';
+
+  // NOTE: Title and namespace come ahead of the page id
+  while (pageId == 0 && !isPageEnd && (readLength = getline(&filter->line, &filter->lineSize, inputFile)) > 0) {
+    readLine = &filter->line[strspn(filter->line, " \t")];
+    ++lineCount;
+
+    if (strncmp(readLine, "<title>", 7) == 0) {
+      filter->title = (char*) realloc(filter->title, sizeof(char) * readLength);
+      memcpy(filter->title, &readLine[7], strcspn(&readLine[7], "<\r\n"));
+      filter->title[strcspn(&readLine[7], "<\r\n")] = '\0';
+    } else if (strncmp(readLine, "<ns>", 4) == 0) {
+      namespaceKey = strtol(&readLine[4], NULL, 10);
+      hasNamespace = true;
+    } else if (strncmp(readLine, "<id>", 4) == 0) pageId = strtoul(&readLine[4], NULL, 10);
+    else if (strncmp(readLine, "<revision>", 10) == 0) break;
+
+    isPageEnd = strncmp(readLine, "</page>", 7) == 0;
+  }
+
+  if (!hasNamespace && filter->title != NULL) {
+    prefixLength = strcspn(filter->title, ":");
+    if (filter->title[prefixLength] == ':' && prefixLength != 0 && prefixLength <= NAMESPACENAMELENGTH) {
+      entry = findNamespace(parserRunTimeData->namespaces, filter->title, prefixLength);
+      if (entry != NULL && entry->key != INTERWIKIKEY) namespaceKey = entry->key;
+    }
+  }
+
+  if (isPageMatching(filter, filter->title == NULL ? "" : filter->title, namespaceKey, pageId)) {
+    ++filter->pageCount;
+    fseeko(inputFile, startPosition, SEEK_SET);
+    return false;
+  }
+
+  while (!isPageEnd && (readLength = getline(&filter->line, &filter->lineSize, inputFile)) > 0) {
+    readLine = &filter->line[strspn(filter->line, " \t")];
+    ++lineCount;
+    isPageEnd = strncmp(readLine, "</page>", 7) == 0;
+  }
+
+  ++filter->skippedCount;
+  *inputBytes += ftello(inputFile) - startPosition;
+  parserRunTimeData->currentLine += lineCount;
+
+  return true;
+}
+
+bool isPageMatching(const pageFilter *filter, const char *title, const short namespaceKey, const unsigned int pageId) {
+  bool isMatching = filter->namespaceCount == 0;
+
+  for (unsigned int i = 0; i < filter->namespaceCount && !isMatching; ++i) isMatching = filter->namespaces[i] == namespaceKey;
+  if (!isMatching || pageId < filter->firstId || pageId > filter->lastId) return false;
+
+  isMatching = filter->prefixCount == 0;
+  for (unsigned int i = 0; i < filter->prefixCount && !isMatching; ++i) isMatching = strncmp(title, filter->prefixes[i], strlen(filter->prefixes[i])) == 0;
+  if (!isMatching) return false;
+
+  return !filter->hasRegex || regexec(&filter->titleRegex, title, 0, NULL, 0) == 0;
+}
+
+void freePageFilters(pageFilter *filter) {
+  if (filter->hasRegex) regfree(&filter->titleRegex);
+  free(filter->namespaces);
+  free(filter->prefixes);
+  free(filter->line);
+  free(filter->title);
+  filter->namespaces = NULL;
+  filter->prefixes = NULL;
+  filter->line = NULL;
+  filter->title = NULL;
+  filter->hasRegex = false;
+  filter->namespaceCount = 0;
+  filter->prefixCount = 0;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Returns the byte length of the punctuation character at "data" or 0.
+        Bytes of multibyte characters are never taken for ASCII punctuation.
+*/
+unsigned short punctuationLength(const char *data, const unsigned int dataLength) {
+  if ((unsigned char) data[0] < 0x80) return ispunct(data[0]) ? 1 : 0;
+
+  for (unsigned short i = 0; i < PUNCTUATIONS; ++i) {
+    unsigned short charLength = strlen(punctuations[i]);
+    if (charLength <= dataLength && strncmp(data, punctuations[i], charLength) == 0) return charLength;
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Returns the count of invalid UTF-8 sequences in "data". Plain ASCII is
+        skipped 16 bytes at once (SSE2) or 8 bytes at once otherwise, only
+        multibyte characters are checked byte by byte for overlong forms,
+        surrogates and code points above U+10FFFF. With "replaced" the data is
+        copied there with U+FFFD for each invalid sequence, it needs room for
+        dataLength + 2 * invalid sequences + 1 bytes.
+*/
+unsigned int validateUTF8(const char *data, const unsigned int dataLength, char *replaced, unsigned int *replacedLength) {
+  const unsigned char *bytes = (const unsigned char*) data;
+  unsigned int readerPos = 0;
+  unsigned int invalidCount = 0;
+  unsigned int invalidLength = 0;
+  unsigned int copiedPos = 0;
+  unsigned int writerPos = 0;
+  unsigned short charLength = 0;
+  unsigned char minNext = 0x80;
+  unsigned char maxNext = 0xBF;
+
+  while (readerPos < dataLength) {
+    #if defined(__SSE2__)
+    if (readerPos + 16 <= dataLength && _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) &bytes[readerPos])) == 0) {
+      readerPos += 16;
+      continue;
+    }
+    #else
+    unsigned long long block = 0;
+    if (readerPos + 8 <= dataLength) {
+      memcpy(&block, &bytes[readerPos], 8);
+      if ((block & 0x8080808080808080ULL) == 0) {
+        readerPos += 8;
+        continue;
+      }
+    }
+    #endif
+
+    if (bytes[readerPos] < 0x80) {
+      ++readerPos;
+      continue;
+    }
+
+    minNext = 0x80;
+    maxNext = 0xBF;
+
+    if (bytes[readerPos] >= 0xC2 && bytes[readerPos] <= 0xDF) charLength = 2;
+    else if (bytes[readerPos] >= 0xE0 && bytes[readerPos] <= 0xEF) {
+      charLength = 3;
+      if (bytes[readerPos] == 0xE0) minNext = 0xA0;
+      else if (bytes[readerPos] == 0xED) maxNext = 0x9F;
+    } else if (bytes[readerPos] >= 0xF0 && bytes[readerPos] <= 0xF4) {
+      charLength = 4;
+      if (bytes[readerPos] == 0xF0) minNext = 0x90;
+      else if (bytes[readerPos] == 0xF4) maxNext = 0x8F;
+    } else charLength = 0;
+
+    invalidLength = 0;
+    if (charLength == 0 || readerPos + charLength > dataLength || bytes[readerPos + 1] < minNext || bytes[readerPos + 1] > maxNext) invalidLength = 1;
+    else {
+      unsigned short i = 2;
+      for (; i < charLength; ++i) {
+        if ((bytes[readerPos + i] & 0xC0) != 0x80) break;
+      }
+
+      if (i != charLength) invalidLength = i;
+    }
+
+    if (invalidLength == 0) {
+      readerPos += charLength;
+      continue;
+    }
+
+    ++invalidCount;
+
+    if (replaced != NULL) {
+      memcpy(&replaced[writerPos], &data[copiedPos], readerPos - copiedPos);
+      writerPos += readerPos - copiedPos;
+      memcpy(&replaced[writerPos], "\xEF\xBF\xBD", 3);
+      writerPos += 3;
+      copiedPos = readerPos + invalidLength;
+    }
+
+    readerPos += invalidLength;
+  }
+
+  if (replaced != NULL) {
+    memcpy(&replaced[writerPos], &data[copiedPos], dataLength - copiedPos);
+    writerPos += dataLength - copiedPos;
+    replaced[writerPos] = '\0';
+    *replacedLength = writerPos;
+  }
+
+  return invalidCount;
+}
+
+
+//------------------------------------------------------------------------------
+bool writeOutDataFiles(const struct parserBaseStore* parserRunTimeData, struct xmlDataCollection* xmlCollection) {
+  bool isWritten = true;
+
+  #if STRAIGHTWRITEOUT
+    struct xmlNode *xmlTag = NULL;
+    struct wikiTag *wTag = NULL;
+    struct word* wordElement = NULL;
+    struct entity* entityElement = NULL;
+
+    for (unsigned int i = 0; i < xmlCollection->count; ++i) {
+      xmlTag = &xmlCollection->nodes[i];
+      outputNodeRow(parserRunTimeData->xmltagOutput, xmlTag, false);
+
+      for (unsigned int j = 0; j < xmlTag->keyValuePairs; ++j) {
+        outputPairRow(parserRunTimeData->xmldataOutput, xmlTag->start, xmlTag->start, xmlTag->end, xmlTag->keyValues[j].key, xmlTag->keyValues[j].value, false);
+      }
+
+      for (unsigned int j = 0; j < xmlTag->wordCount; ++j) {
+        wordElement = &xmlTag->words[j];
+        outputWordRow(parserRunTimeData->dictOutput, wordElement, -1, 0);
+      }
+
+      for (unsigned int j = 0; j < xmlTag->entityCount; ++j) {
+        entityElement = &xmlTag->entities[j];
+        outputEntityRow(parserRunTimeData->entitiesOutput, entityElement, -1, 0);
+      }
+
+      for (unsigned int j = 0; j < xmlTag->wTagCount; ++j) {
+        wTag = &xmlTag->wikiTags[j];
+        writeOutTagData(parserRunTimeData, wTag);
+      }
+    }
+
+    for (unsigned int i = 0; i < xmlCollection->redirectCount; ++i) {
+      outputPairRow(parserRunTimeData->redirectsOutput, xmlCollection->redirects[i].lineNum, xmlCollection->redirects[i].pageId, xmlCollection->redirects[i].lineNum, xmlCollection->redirects[i].title, xmlCollection->redirects[i].target, false);
+    }
+  #else
+    // SORTED WRITE OUT
+    if (parserRunTimeData->runs->count != 0) {
+      // NOTE: The rows left are spilled as the last run and all runs merged
+      isWritten = spillSortedRun(parserRunTimeData, xmlCollection, true);
+      if (!mergeSortedRuns(parserRunTimeData)) isWritten = false;
+    } else writeOutSortedRows(parserRunTimeData, xmlCollection, 1, NULL);
+
+    for (unsigned int i = 0; i < xmlCollection->redirectCount; ++i) {
+      outputPairRow(parserRunTimeData->redirectsOutput, xmlCollection->redirects[i].lineNum, xmlCollection->redirects[i].pageId, xmlCollection->redirects[i].lineNum, xmlCollection->redirects[i].title, xmlCollection->redirects[i].target, true);
+    }
+
+  #endif
+  return isWritten;
+}
+
+// ----------------------------------------------------------
+
+/*
+  NOTE: Writes the rows of the sorted write out from "firstLine" on. Nodes
+        marked in "isOpen" are left for a later run, all nodes are written
+        without it.
+*/
+void writeOutSortedRows(const struct parserBaseStore* parserRunTimeData, struct xmlDataCollection* xmlCollection, const unsigned int firstLine, const bool *isOpen) {
+  struct xmlNode *xmlTag = NULL;
+  struct wikiTag *wTag = NULL;
+  struct word* wordElement = NULL;
+  struct entity* entityElement = NULL;
+
+  for (unsigned int i = 0; i < xmlCollection->count; ++i) {
+    xmlTag = &xmlCollection->nodes[i];
+    if (isOpen != NULL && isOpen[i]) continue;
+
+    outputNodeRow(parserRunTimeData->xmltagOutput, xmlTag, true);
+
+    for (unsigned int j = 0; j < xmlTag->keyValuePairs; ++j) {
+      outputPairRow(parserRunTimeData->xmldataOutput, xmlTag->start, xmlTag->start, xmlTag->end, xmlTag->keyValues[j].key, xmlTag->keyValues[j].value, true);
+    }
+  }
+
+  unsigned int lineNum = firstLine;
+  unsigned int lastChecked = 0;
+  while (lineNum <= parserRunTimeData->currentLine) {
+    for (unsigned int i = lastChecked; i < xmlCollection->count; ++i) {
+      xmlTag = &xmlCollection->nodes[i];
+      if (xmlTag->start > lineNum) break;
+      lastChecked = i;
+
+
+      for (unsigned int j = 0; j < xmlTag->wordCount; ++j) {
+        wordElement = &xmlTag->words[j];
+        if (wordElement->lineNum == lineNum) {
+          outputWordRow(parserRunTimeData->dictOutput, wordElement, -1, OUTPUTHEXPOSITION | OUTPUTHEXPRESPACES | OUTPUTHEXSPACES);
+        }
+      }
+
+      for (unsigned int j = 0; j < xmlTag->entityCount; ++j) {
+        entityElement = &xmlTag->entities[j];
+        if (entityElement->lineNum == lineNum) {
+          outputEntityRow(parserRunTimeData->entitiesOutput, entityElement, -1, OUTPUTHEXPOSITION | OUTPUTHEXPRESPACES | OUTPUTHEXSPACES);
+        }
+      }
+
+      for (unsigned int j = 0; j < xmlTag->wTagCount; ++j) {
+        wTag = &xmlTag->wikiTags[j];
+        if (wTag->lineNum == lineNum) {
+          writeOutTagDataByLine(parserRunTimeData, wTag, lineNum);
+        }
+      }
+    }
+
+    ++lineNum;
+  }
+}
+
+// ----------------------------------------------------------
+
+bool writeOutTagDataByLine(const struct parserBaseStore* parserRunTimeData, wikiTag *wTag, const unsigned int lineNum) {
+  struct word wordElement;
+  struct entity entityElement;
+  struct wikiTag wikiTagElement;
+
+  outputTagRow(parserRunTimeData->wtagOutput, wTag);
+
+  for (unsigned int k = 0; k < wTag->wTagCount; ++k) {
+    wikiTagElement = wTag->pipedTags[k];
+    shiftSharedChild(wTag, &wikiTagElement.position, &wikiTagElement.lineNum);
+    writeOutTagDataByLine(parserRunTimeData, &wikiTagElement, lineNum);
+  }
+
+  for (unsigned int k = 0; k < wTag->wordCount; ++k) {
+    wordElement = wTag->pipedWords[k];
+    shiftSharedChild(wTag, &wordElement.position, &wordElement.lineNum);
+    outputWordRow(parserRunTimeData->dictOutput, &wordElement, wTag->position, OUTPUTHEXPOSITION | OUTPUTHEXPRESPACES | OUTPUTHEXSPACES);
+  }
+
+  for (unsigned int k = 0; k < wTag->entityCount; ++k) {
+    entityElement = wTag->pipedEntities[k];
+    shiftSharedChild(wTag, &entityElement.position, &entityElement.lineNum);
+    outputEntityRow(parserRunTimeData->entitiesOutput, &entityElement, wTag->position, OUTPUTHEXPOSITION | OUTPUTHEXPRESPACES);
+  }
+
+  return true;
+}
+
+bool writeOutTagData(const struct parserBaseStore* parserRunTimeData, wikiTag *wTag) {
+  struct word wordElement;
+  struct entity entityElement;
+  struct wikiTag wikiTagElement;
+
+  outputTagRow(parserRunTimeData->wtagOutput, wTag);
+
+
+  for (unsigned int k = 0; k < wTag->wordCount; ++k) {
+    wordElement = wTag->pipedWords[k];
+    shiftSharedChild(wTag, &wordElement.position, &wordElement.lineNum);
+    outputWordRow(parserRunTimeData->dictOutput, &wordElement, wTag->position, OUTPUTHEXPOSITION | OUTPUTHEXPARENT | OUTPUTHEXPRESPACES | OUTPUTHEXSPACES);
+  }
+
+
+  for (unsigned int k = 0; k < wTag->entityCount; ++k) {
+    entityElement = wTag->pipedEntities[k];
+    shiftSharedChild(wTag, &entityElement.position, &entityElement.lineNum);
+    outputEntityRow(parserRunTimeData->entitiesOutput, &entityElement, wTag->position, OUTPUTHEXPOSITION | OUTPUTHEXPARENT | OUTPUTHEXPRESPACES | OUTPUTHEXSPACES);
+  }
+
+  for (unsigned int k = 0; k < wTag->wTagCount; ++k) {
+    wikiTagElement = wTag->pipedTags[k];
+    shiftSharedChild(wTag, &wikiTagElement.position, &wikiTagElement.lineNum);
+    writeOutTagData(parserRunTimeData, &wikiTagElement);
+  }
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: The text write out formats its numbers by hand into a large buffer per
+        file instead of fprintf, the rows are byte identical to the printf
+        formats "%x" and "%d" used before.
+*/
+const char digitPairs[201] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+const char hexDigits[17] = "0123456789abcdef";
+
+void initOutputBuffer(outputBuffer *output, FILE *outputFile, const char *fileName, asyncWriter *writer) {
+  output->fileDescriptor = outputFile == NULL ? -1 : fileno(outputFile);
+  output->fileName = fileName;
+  output->shardIndex = 0;
+  output->shardBytes = NULL;
+  output->shards = NULL;
+  output->pageIndex = 0;
+  output->pageCount = 0;
+  output->pages = NULL;
+  output->pageOffsets = NULL;
+  output->incremental = NULL;
+  output->fileIndex = 0;
+  output->reusedIndex = 0;
+  output->writtenBytes = 0;
+  output->length = 0;
+  output->size = 0;
+  output->bufferIndex = 0;
+  output->fileOffset = 0;
+  output->data = NULL;
+  output->writer = writer;
+  output->isCompressed = COMPRESSWRITEOUT != COMPRESSNONE;
+  output->hasFailed = false;
+  output->vocabulary = NULL;
+  output->targets = NULL;
+  output->dataBytes = 0;
+
+  for (unsigned short i = 0; i < OUTPUTBUFFERS; ++i) {
+    output->buffers[i] = NULL;
+    output->isPending[i] = false;
+    #if COMPRESSWRITEOUT != COMPRESSNONE
+    output->compressedSize[i] = 0;
+    output->compressedBuffers[i] = NULL;
+    #endif
+  }
+
+  #if COMPRESSWRITEOUT == COMPRESSGZIP
+  memset(&output->compressor, 0, sizeof(z_stream));
+  // NOTE: Window bits 15 + 16 write a gzip header and trailer
+  // NOTE: A compressor which cannot be started fails the write out of the file
+  if (deflateInit2(&output->compressor, COMPRESSLEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) output->hasFailed = true;
+  #endif
+}
+
+//------------------------------------------------------------------------------
+
+bool writeOutputData(const int fileDescriptor, const char *data, const unsigned int dataLength, const unsigned long long offset) {
+  unsigned int writerPos = 0;
+  ssize_t written = 0;
+
+  while (writerPos < dataLength) {
+    written = pwrite(fileDescriptor, &data[writerPos], dataLength - writerPos, offset + writerPos);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) return false;
+    writerPos += written;
+  }
+
+  return true;
+}
+
+/*
+  NOTE: Without a writer the buffer is written right away, else it is handed
+        to the writer and the next buffer is used once its own earlier write
+        has finished.
+*/
+bool flushOutputBuffer(outputBuffer *output, const bool isFinal) {
+  bool isWritten = true;
+  const char *writeData = output->data;
+  unsigned int writeLength = output->length;
+
+  if (output->length == 0 && !isFinal) return true;
+  output->dataBytes += output->length;
+
+  #if COMPRESSWRITEOUT != COMPRESSNONE
+  if (output->isCompressed) {
+    writeLength = compressOutput(output, isFinal);
+    writeData = output->compressedBuffers[output->bufferIndex];
+  }
+  #endif
+
+  if (writeLength == 0) {
+    output->length = 0;
+    return true;
+  }
+
+  if (output->writer == NULL) {
+    isWritten = writeOutputData(output->fileDescriptor, writeData, writeLength, output->fileOffset);
+  } else {
+    submitAsyncWrite(output->writer, output->fileDescriptor, writeData, writeLength, output->fileOffset, &output->isPending[output->bufferIndex]);
+    output->bufferIndex = (output->bufferIndex + 1) % OUTPUTBUFFERS;
+
+    if (output->buffers[output->bufferIndex] == NULL) output->buffers[output->bufferIndex] = malloc(sizeof(char) * output->size);
+    waitAsyncWrite(output->writer, &output->isPending[output->bufferIndex]);
+    output->data = output->buffers[output->bufferIndex];
+  }
+
+  if (!isWritten) output->hasFailed = true;
+  output->fileOffset += writeLength;
+  output->writtenBytes += writeLength;
+  output->length = 0;
+  return isWritten;
+}
+
+/*
+  NOTE: Ends the current file, a shard file is closed and its size kept for
+        the manifest.
+*/
+bool finishOutputFile(outputBuffer *output) {
+  bool isFlushed = flushOutputBuffer(output, true);
+
+  for (unsigned short i = 0; i < OUTPUTBUFFERS; ++i) {
+    if (output->writer != NULL) waitAsyncWrite(output->writer, &output->isPending[i]);
+  }
+
+  #if COMPRESSWRITEOUT == COMPRESSGZIP
+  deflateReset(&output->compressor);
+  #endif
+
+  if (output->shards != NULL) {
+    output->shardBytes = (unsigned long long*) realloc(output->shardBytes, sizeof(unsigned long long) * (output->shardIndex + 1));
+    output->shardBytes[output->shardIndex] = output->fileOffset;
+    close(output->fileDescriptor);
+    output->fileDescriptor = -1;
+  }
+
+  return isFlushed;
+}
+
+bool closeOutputBuffer(outputBuffer *output) {
+  bool isFlushed = true;
+
+  if (output->shards != NULL) {
+    // NOTE: Shards without rows are written as empty files
+    for (; output->shardIndex < output->shards->count; ++output->shardIndex) {
+      if (output->fileDescriptor == -1 && !openOutputShard(output)) isFlushed = false;
+      else if (!finishOutputFile(output)) isFlushed = false;
+    }
+  } else if (output->fileDescriptor != -1) isFlushed = finishOutputFile(output);
+
+  for (unsigned short i = 0; i < OUTPUTBUFFERS; ++i) {
+    free(output->buffers[i]);
+    output->buffers[i] = NULL;
+    #if COMPRESSWRITEOUT != COMPRESSNONE
+    free(output->compressedBuffers[i]);
+    output->compressedBuffers[i] = NULL;
+    #endif
+  }
+
+  #if COMPRESSWRITEOUT == COMPRESSGZIP
+  deflateEnd(&output->compressor);
+  #endif
+
+  if (output->hasFailed || (output->writer != NULL && output->writer->hasFailed)) isFlushed = false;
+
+  output->data = NULL;
+  output->size = 0;
+  return isFlushed;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Makes room for "length" bytes, returns NULL for data larger than the buffer.
+*/
+static inline char* reserveOutput(outputBuffer *output, const unsigned int length) {
+  if (output->data == NULL) {
+    output->size = OUTPUTBUFFERSIZE;
+    output->buffers[output->bufferIndex] = malloc(sizeof(char) * output->size);
+    output->data = output->buffers[output->bufferIndex];
+  }
+
+  if (output->length + length > output->size) flushOutputBuffer(output, false);
+  if (length > output->size) return NULL;
+
+  return &output->data[output->length];
+}
+
+/*
+  NOTE: Called ahead of each row, pages starting up to the line of the row
+        start at the current byte of the file. Pages reused by INCREMENTAL
+        get their rows of the previous run there.
+*/
+static inline void markOutputRow(outputBuffer *output, const unsigned int lineNum) {
+  while (output->pageIndex < output->pageCount && output->pages[output->pageIndex].startLine <= lineNum) {
+    output->pageOffsets[output->pageIndex] = output->dataBytes + output->length;
+    if (output->incremental != NULL && output->reusedIndex < output->incremental->reusedCount && output->incremental->reused[output->reusedIndex].record == output->pageIndex) {
+      copyReusedRows(output);
+    }
+    ++output->pageIndex;
+  }
+
+  if (output->shards != NULL) selectOutputShard(output, lineNum);
+}
+
+void appendOutput(outputBuffer *output, const char *data, const unsigned int dataLength) {
+  char *writer = reserveOutput(output, dataLength);
+
+  if (writer == NULL) {
+    // NOTE: Goes through the buffer in parts, so it is compressed as well
+    for (unsigned int readerPos = 0; readerPos < dataLength; readerPos += output->size) {
+      appendOutput(output, &data[readerPos], dataLength - readerPos < output->size ? dataLength - readerPos : output->size);
+    }
+    return;
+  }
+
+  memcpy(writer, data, dataLength);
+  output->length += dataLength;
+}
+
+static inline void appendChar(outputBuffer *output, const char data) {
+  *reserveOutput(output, 1) = data;
+  ++output->length;
+}
+
+/*
+  NOTE: Copies the rows of the next reused page from the file of the previous
+        run. Their lines are moved by the lines the page moved in the source,
+        the lines are the second column of the rows and the first one of xml
+        tags and xml data, like the keys of readRowKey.
+*/
+void copyReusedRows(outputBuffer *output) {
+  const incrementalRun *incremental = output->incremental;
+  const reusedPage *reused = &incremental->reused[output->reusedIndex];
+  const previousPage *previous = &incremental->previous[reused->previousRecord];
+  const unsigned short fileIndex = output->fileIndex;
+  const unsigned long long dataLength = previous->endBytes[fileIndex] - previous->startBytes[fileIndex];
+  const unsigned int lineShift = output->pages[reused->record].startLine - previous->startLine;
+  const unsigned short lineColumns = fileIndex == 2 || fileIndex == 3 ? 2 : 1;
+  unsigned long long readBytes = 0;
+  ssize_t readLength = 0;
+  char *data = malloc(sizeof(char) * (dataLength + 1));
+  char *row = data;
+  char *field = NULL;
+
+  ++output->reusedIndex;
+
+  while (data != NULL && readBytes < dataLength) {
+    readLength = pread(incremental->previousFiles[fileIndex], &data[readBytes], dataLength - readBytes, previous->startBytes[fileIndex] + readBytes);
+    if (readLength <= 0) break;
+    readBytes += readLength;
+  }
+
+  // NOTE: Rows cut short would be copied as they are, the file is marked as failed instead
+  if (data == NULL || readBytes != dataLength) {
+    printf("[ ERROR ] Cannot read the rows of page %u from the previous \"%s\".\n", output->pages[reused->record].pageId, output->fileName);
+    output->hasFailed = true;
+    free(data);
+    return;
+  }
+  data[readBytes] = '\0';
+
+  // NOTE: Lines are unsigned, the shift wraps around for pages moved up
+  while (row < &data[readBytes]) {
+    char *rowEnd = strchr(row, '\n');
+    if (rowEnd == NULL) rowEnd = &data[readBytes - 1];
+
+    field = row;
+    if (lineColumns == 1 && (field = memchr(row, '\t', rowEnd - row)) != NULL) {
+      ++field;
+      appendOutput(output, row, field - row);
+    }
+    if (field == NULL) field = row;
+
+    for (unsigned short i = 0; i < lineColumns; ++i) {
+      if (i != 0) {
+        appendChar(output, '\t');
+        ++field;
+      }
+      appendHex(output, (unsigned int) strtoul(field, &field, 16) + lineShift);
+    }
+
+    appendOutput(output, field, rowEnd + 1 - field);
+    row = rowEnd + 1;
+  }
+
+  free(data);
+}
+
+// NOTE: Reused pages after the last row of the file
+void finishReusedRows(outputBuffer *output) {
+  markOutputRow(output, UINT_MAX);
+}
+
+//------------------------------------------------------------------------------
+
+void appendHex(outputBuffer *output, unsigned int value) {
+  char digits[8];
+  unsigned short digitPos = 8;
+
+  do {
+    digits[--digitPos] = hexDigits[value & 0xF];
+    value >>= 4;
+  } while (value != 0);
+
+  appendOutput(output, &digits[digitPos], 8 - digitPos);
+}
+
+void appendDecimal(outputBuffer *output, const long long value) {
+  char digits[20];
+  unsigned short digitPos = 20;
+  unsigned long long number = value < 0 ? -(unsigned long long) value : (unsigned long long) value;
+  unsigned int pairIndex = 0;
+
+  while (number >= 100) {
+    pairIndex = (number % 100) * 2;
+    number /= 100;
+    digits[--digitPos] = digitPairs[pairIndex + 1];
+    digits[--digitPos] = digitPairs[pairIndex];
+  }
+
+  if (number >= 10) {
+    digits[--digitPos] = digitPairs[number * 2 + 1];
+    digits[--digitPos] = digitPairs[number * 2];
+  } else digits[--digitPos] = '0' + number;
+
+  if (value < 0) appendChar(output, '-');
+  appendOutput(output, &digits[digitPos], 20 - digitPos);
+}
+
+static inline void appendNumber(outputBuffer *output, const long long value, const bool isHex) {
+  if (isHex) appendHex(output, value);
+  else appendDecimal(output, value);
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: "hexFields" holds the OUTPUTHEX... flags of the fields written as hex,
+        the remaining numbers are written as decimal. With FORMATSPANS the four
+        format columns of words, entities and wikitags are left out, the formats
+        are written as spans to FORMATSPANSFILE.
+*/
+void outputWordRow(outputBuffer *output, const word *wordElement, const long long parent, const unsigned char hexFields) {
+  const unsigned int dataLength = strlen(wordElement->data);
+
+  markOutputRow(output, wordElement->lineNum);
+
+  appendNumber(output, wordElement->position, hexFields & OUTPUTHEXPOSITION);
+  appendChar(output, '\t');
+  appendNumber(output, wordElement->lineNum, hexFields & OUTPUTHEXPOSITION);
+  appendChar(output, '\t');
+  appendNumber(output, parent, hexFields & OUTPUTHEXPARENT);
+  appendChar(output, '\t');
+  appendNumber(output, wordElement->preSpacesCount, hexFields & OUTPUTHEXPRESPACES);
+  appendChar(output, '\t');
+  appendNumber(output, wordElement->spacesCount, hexFields & OUTPUTHEXSPACES);
+  appendChar(output, '\t');
+  appendDecimal(output, dataLength);
+  appendChar(output, '\t');
+  if (!FORMATSPANS) {
+    appendDecimal(output, wordElement->dataFormatType);
+    appendChar(output, '\t');
+    appendDecimal(output, wordElement->ownFormatType);
+    appendChar(output, '\t');
+    appendDecimal(output, wordElement->formatStart);
+    appendChar(output, '\t');
+    appendDecimal(output, wordElement->formatEnd);
+    appendChar(output, '\t');
+  }
+  appendDecimal(output, wordElement->hasPipe);
+  appendChar(output, '\t');
+  if (output->vocabulary != NULL) appendDecimal(output, findVocabularyWord(output->vocabulary, wordElement->data)->rank);
+  else appendOutput(output, wordElement->data, dataLength);
+  appendChar(output, '\n');
+}
+
+void outputEntityRow(outputBuffer *output, const entity *entityElement, const long long parent, const unsigned char hexFields) {
+  markOutputRow(output, entityElement->lineNum);
+  appendNumber(output, entityElement->position, hexFields & OUTPUTHEXPOSITION);
+  appendChar(output, '\t');
+  appendNumber(output, entityElement->lineNum, hexFields & OUTPUTHEXPOSITION);
+  appendChar(output, '\t');
+  appendNumber(output, parent, hexFields & OUTPUTHEXPARENT);
+  appendChar(output, '\t');
+  appendNumber(output, entityElement->preSpacesCount, hexFields & OUTPUTHEXPRESPACES);
+  appendChar(output, '\t');
+  appendNumber(output, entityElement->spacesCount, hexFields & OUTPUTHEXSPACES);
+  appendChar(output, '\t');
+  if (!FORMATSPANS) {
+    appendDecimal(output, entityElement->dataFormatType);
+    appendChar(output, '\t');
+    appendDecimal(output, entityElement->ownFormatType);
+    appendChar(output, '\t');
+    appendDecimal(output, entityElement->formatStart);
+    appendChar(output, '\t');
+    appendDecimal(output, entityElement->formatEnd);
+    appendChar(output, '\t');
+  }
+  appendDecimal(output, entityElement->hasPipe);
+  appendChar(output, '\t');
+  appendOutput(output, entityElement->data, strlen(entityElement->data));
+  appendChar(output, '\n');
+}
+
+void outputTagRow(outputBuffer *output, const wikiTag *wTag) {
+  const char *target = output->targets->data[wTag->target];
+  const unsigned int targetLength = strlen(target);
+
+  markOutputRow(output, wTag->lineNum);
+
+  appendHex(output, wTag->position);
+  appendChar(output, '\t');
+  appendHex(output, wTag->lineNum);
+  appendChar(output, '\t');
+  appendHex(output, wTag->preSpacesCount);
+  appendChar(output, '\t');
+  appendHex(output, wTag->spacesCount);
+  appendChar(output, '\t');
+  appendDecimal(output, wTag->tagType);
+  appendChar(output, '\t');
+  if (!FORMATSPANS) {
+    appendDecimal(output, wTag->dataFormatType);
+    appendChar(output, '\t');
+    appendDecimal(output, wTag->ownFormatType);
+    appendChar(output, '\t');
+    appendDecimal(output, wTag->formatStart);
+    appendChar(output, '\t');
+    appendDecimal(output, wTag->formatEnd);
+    appendChar(output, '\t');
+  }
+  appendDecimal(output, wTag->tagLength);
+  appendChar(output, '\t');
+  appendDecimal(output, targetLength);
+  appendChar(output, '\t');
+  appendDecimal(output, wTag->hasPipe);
+  appendChar(output, '\t');
+  if (TARGETIDS) appendDecimal(output, wTag->target);
+  else appendOutput(output, target, targetLength);
+  appendChar(output, '\n');
+}
+
+void outputNodeRow(outputBuffer *output, const xmlNode *xmlTag, const bool isHex) {
+  markOutputRow(output, xmlTag->start);
+  appendNumber(output, xmlTag->start, isHex);
+  appendChar(output, '\t');
+  appendNumber(output, xmlTag->end, isHex);
+  appendChar(output, '\t');
+  appendDecimal(output, xmlTag->isClosed);
+  appendChar(output, '\t');
+  appendDecimal(output, xmlTag->isDataNode);
+  appendChar(output, '\t');
+  appendOutput(output, xmlTag->name, strlen(xmlTag->name));
+  appendChar(output, '\n');
+}
+
+void outputPairRow(outputBuffer *output, const unsigned int lineNum, const unsigned int start, const unsigned int end, const char *key, const char *value, const bool isHex) {
+  markOutputRow(output, lineNum);
+  appendNumber(output, start, isHex);
+  appendChar(output, '\t');
+  appendNumber(output, end, isHex);
+  appendChar(output, '\t');
+  appendOutput(output, key, strlen(key));
+  appendChar(output, '\t');
+  appendOutput(output, value, strlen(value));
+  appendChar(output, '\n');
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Splits the pages into shards by SHARDCOUNT shards, SHARDPAGES pages or
+        SHARDBYTES bytes of the source file, whatever comes first. The first
+        shard holds the lines ahead of the first page as well.
+*/
+void buildOutputShards(const xmlDataCollection *xmlCollection, shardTable *shards) {
+  unsigned int pagesPerShard = SHARDPAGES;
+  unsigned int pagesInShard = 0;
+  unsigned long long shardStartByte = 0;
+  const page *currentPage = NULL;
+
+  #if SHARDCOUNT != 0
+  unsigned int countPages = (xmlCollection->pageCount + SHARDCOUNT - 1) / SHARDCOUNT;
+  if (pagesPerShard == 0 || countPages < pagesPerShard) pagesPerShard = countPages;
+  #endif
+
+  shards->count = 1;
+  shards->startLines = malloc(sizeof(unsigned int));
+  shards->firstPages = malloc(sizeof(unsigned int));
+  shards->startLines[0] = 0;
+  shards->firstPages[0] = 0;
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) {
+    currentPage = &xmlCollection->pages[i];
+
+    if (pagesInShard != 0 && ((pagesPerShard != 0 && pagesInShard >= pagesPerShard) || (SHARDBYTES != 0 && currentPage->startByte - shardStartByte >= SHARDBYTES))) {
+      shards->startLines = (unsigned int*) realloc(shards->startLines, sizeof(unsigned int) * (shards->count + 1));
+      shards->firstPages = (unsigned int*) realloc(shards->firstPages, sizeof(unsigned int) * (shards->count + 1));
+      shards->startLines[shards->count] = currentPage->startLine;
+      shards->firstPages[shards->count] = i;
+      ++shards->count;
+
+      shardStartByte = currentPage->startByte;
+      pagesInShard = 0;
+    }
+
+    ++pagesInShard;
+  }
+}
+
+/*
+  NOTE: Rows come in line order, so the shard only moves forward. Rows of a
+        line ahead of the current shard stay in it, so the shards joined give
+        the same file as without shards.
+*/
+void selectOutputShard(outputBuffer *output, const unsigned int lineNum) {
+  if (output->shards == NULL) return;
+
+  unsigned int shardIndex = output->shardIndex;
+  while (shardIndex + 1 < output->shards->count && output->shards->startLines[shardIndex + 1] <= lineNum) ++shardIndex;
+
+  for (; output->shardIndex < shardIndex; ++output->shardIndex) {
+    if (output->fileDescriptor == -1) openOutputShard(output);
+    finishOutputFile(output);
+  }
+
+  if (output->fileDescriptor == -1) openOutputShard(output);
+}
+
+bool openOutputShard(outputBuffer *output) {
+  char fileName[FILENAMELENGTH];
+
+  shardFileName(fileName, output->fileName, output->shardIndex);
+  output->fileDescriptor = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  output->fileOffset = 0;
+
+  if (output->fileDescriptor == -1) {
+    printf("[ ERROR ] Cannot open shard file \"%s\".\n", fileName);
+    return false;
+  }
+
+  return true;
+}
+
+/*
+  NOTE: The shard number goes ahead of the first extension, "words.txt.gz"
+        becomes "words.0003.txt.gz".
+*/
+void shardFileName(char *shardName, const char *fileName, const unsigned int shardIndex) {
+  const unsigned int nameLength = strcspn(fileName, ".");
+
+  snprintf(shardName, FILENAMELENGTH, "%.*s.%04u%s", nameLength, fileName, shardIndex, &fileName[nameLength]);
+}
+
+/*
+  NOTE: One row per shard with the page id range, line range, page count and
+        the written bytes of each file.
+*/
+bool writeOutManifest(outputBuffer **outputs, const shardTable *shards, const xmlDataCollection *xmlCollection, const unsigned int lineCount) {
+  FILE *manifestFile = fopen(MANIFESTFILE, "w");
+  char shardName[FILENAMELENGTH];
+
+  if (manifestFile == NULL) return false;
+
+  fprintf(manifestFile, "# shard\tfirst page id\tlast page id\tfirst line\tlast line\tpages");
+  for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+    shardFileName(shardName, outputs[i]->fileName, 0);
+    fprintf(manifestFile, "\t%s", shardName);
+  }
+  fputc('\n', manifestFile);
+
+  for (unsigned int i = 0; i < shards->count; ++i) {
+    const bool isLast = i + 1 == shards->count;
+    const unsigned int firstPage = shards->firstPages[i];
+    const unsigned int endPage = isLast ? xmlCollection->pageCount : shards->firstPages[i + 1];
+
+    fprintf(manifestFile, "%04u\t%u\t%u\t%u\t%u\t%u", i,
+      firstPage < endPage ? xmlCollection->pages[firstPage].pageId : 0,
+      firstPage < endPage ? xmlCollection->pages[endPage - 1].pageId : 0,
+      i == 0 ? 1 : shards->startLines[i],
+      isLast ? lineCount : shards->startLines[i + 1] - 1,
+      endPage - firstPage);
+
+    for (unsigned short j = 0; j < OUTPUTFILES; ++j) {
+      fprintf(manifestFile, "\t%llu", outputs[j]->shardBytes == NULL ? 0 : outputs[j]->shardBytes[i]);
+    }
+    fputc('\n', manifestFile);
+  }
+
+  fclose(manifestFile);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Estimates the memory taken by the parsed data, the counters of "cData"
+        keep counting after a run is spilled.
+*/
+unsigned long long collectedBytes(const collectionStatistics *cData, const xmlDataCollection *xmlCollection) {
+  unsigned long long tokenBytes = (unsigned long long) cData->wordCount * sizeof(word) + (unsigned long long) cData->entityCount * sizeof(entity) + (unsigned long long) cData->wikiTagCount * sizeof(wikiTag);
+  unsigned long long nodeBytes = (unsigned long long) (xmlCollection->count + cData->spilledNodes) * sizeof(xmlNode) + (unsigned long long) cData->keyCount * sizeof(keyValuePair);
+
+  return tokenBytes + nodeBytes + cData->byteWords + cData->byteEntites + cData->byteWikiTags + cData->byteKeys + cData->byteValues;
+}
+
+void runFileName(char *fileName, const unsigned int run, const unsigned short kind) {
+  snprintf(fileName, FILENAMELENGTH, "%s/wicked_run.%04u.%u", RUNDIRECTORY, run, kind);
+}
+
+/*
+  NOTE: Writes the rows parsed since the last run sorted into uncompressed run
+        files and frees the closed nodes. Nodes still open stay for the next
+        run, so a run is only spilled while they hold no tokens, which is the
+        case between pages.
+*/
+bool spillSortedRun(const parserBaseStore *parserRunTimeData, xmlDataCollection *xmlCollection, const bool isLast) {
+  sortRuns *runs = parserRunTimeData->runs;
+  outputBuffer runOutputs[RUNFILES];
+  FILE *runFiles[RUNFILES];
+  bool *isOpen = NULL;
+  bool isWritten = true;
+  char fileName[FILENAMELENGTH];
+  unsigned int keptCount = 0;
+
+  if (!isLast) {
+    isOpen = calloc(xmlCollection->count, sizeof(bool));
+    for (unsigned int i = 0; i < xmlCollection->openNodeCount; ++i) {
+      xmlNode *openXMLNode = &xmlCollection->nodes[xmlCollection->openNodes[i]];
+
+      if (openXMLNode->wordCount != 0 || openXMLNode->entityCount != 0 || openXMLNode->wTagCount != 0) {
+        free(isOpen);
+        return false;
+      }
+      isOpen[xmlCollection->openNodes[i]] = true;
+    }
+  }
+
+  for (unsigned short i = 0; i < RUNFILES; ++i) {
+    runFileName(fileName, runs->count, i);
+    runFiles[i] = fopen(fileName, "w");
+    if (runFiles[i] == NULL) isWritten = false;
+
+    initOutputBuffer(&runOutputs[i], runFiles[i], fileName, parserRunTimeData->dictOutput->writer);
+    runOutputs[i].isCompressed = false;
+    runOutputs[i].targets = parserRunTimeData->targets;
+  }
+
+  // NOTE: The rows go to the run files, everything else stays the same
+  parserBaseStore runData = *parserRunTimeData;
+  runData.dictOutput = &runOutputs[0];
+  runData.wtagOutput = &runOutputs[1];
+  runData.xmltagOutput = &runOutputs[2];
+  runData.xmldataOutput = &runOutputs[3];
+  runData.entitiesOutput = &runOutputs[4];
+
+  if (isWritten) writeOutSortedRows(&runData, xmlCollection, runs->startLine, isOpen);
+
+  for (unsigned short i = 0; i < RUNFILES; ++i) {
+    if (!closeOutputBuffer(&runOutputs[i])) isWritten = false;
+    if (runFiles[i] != NULL) fclose(runFiles[i]);
+  }
+
+  // NOTE: A run which failed is removed, its closed nodes stay for the next run
+  if (!isWritten) {
+    printf("[ ERROR ] Cannot write the sorted run %u to \"%s\".\n", runs->count, RUNDIRECTORY);
+    for (unsigned short i = 0; i < RUNFILES; ++i) {
+      runFileName(fileName, runs->count, i);
+      remove(fileName);
+    }
+
+    runs->spilledBytes = collectedBytes(parserRunTimeData->cData, xmlCollection);
+    free(isOpen);
+    return false;
+  }
+
+  #if DEBUG || BEVERBOSE
+  printf("[STATUS] SORTED RUN %u SPILLED | LINES %u - %u\n", runs->count, runs->startLine, parserRunTimeData->currentLine);
+  #endif
+
+  ++runs->count;
+  runs->startLine = parserRunTimeData->currentLine + 1;
+  runs->spilledBytes = collectedBytes(parserRunTimeData->cData, xmlCollection);
+
+  if (isLast) return true;
+
+  // Keep the open nodes only
+  for (unsigned int i = 0; i < xmlCollection->count; ++i) {
+    if (!isOpen[i]) {
+      freeXMLNode(&xmlCollection->nodes[i]);
+      continue;
+    }
+
+    for (unsigned int j = 0; j < xmlCollection->openNodeCount; ++j) {
+      if (xmlCollection->openNodes[j] == i) xmlCollection->openNodes[j] = keptCount;
+    }
+    xmlCollection->nodes[keptCount] = xmlCollection->nodes[i];
+    ++keptCount;
+  }
+
+  parserRunTimeData->cData->spilledNodes += xmlCollection->count - keptCount;
+  xmlCollection->count = keptCount;
+  xmlCollection->nodes = (xmlNode*) realloc(xmlCollection->nodes, sizeof(xmlNode) * (keptCount == 0 ? 1 : keptCount));
+
+  free(isOpen);
+  return true;
+}
+
+/*
+  NOTE: The key of a row is its line number, the second field of tokens and
+        the first of xml tags and data, written as hex.
+*/
+unsigned int readRowKey(const char *row, const unsigned short kind) {
+  if (kind == 0 || kind == 1 || kind == 4) row = strchr(row, '\t') + 1;
+  return strtoul(row, NULL, 16);
+}
+
+// Heap of runs ordered by the key of their next row and the run number
+static inline bool isRunBefore(const unsigned int *keys, const unsigned int runA, const unsigned int runB) {
+  return keys[runA] < keys[runB] || (keys[runA] == keys[runB] && runA < runB);
+}
+
+static inline void siftRunHeap(unsigned int *heap, const unsigned int *keys, const unsigned int heapCount, unsigned int parent) {
+  unsigned int child = 0;
+  unsigned int swap = 0;
+
+  while (parent * 2 + 1 < heapCount) {
+    child = parent * 2 + 1;
+    if (child + 1 < heapCount && isRunBefore(keys, heap[child + 1], heap[child])) ++child;
+    if (!isRunBefore(keys, heap[child], heap[parent])) break;
+
+    swap = heap[parent];
+    heap[parent] = heap[child];
+    heap[child] = swap;
+    parent = child;
+  }
+}
+
+/*
+  NOTE: K-way merge of the runs into the text files, the run with the lowest
+        key of its next row is taken first and earlier runs win on equal keys.
+        The runs are sorted on their own, so rows of one run keep their order.
+*/
+bool mergeSortedRuns(const parserBaseStore *parserRunTimeData) {
+  outputBuffer *mergeOutputs[RUNFILES] = {parserRunTimeData->dictOutput, parserRunTimeData->wtagOutput, parserRunTimeData->xmltagOutput, parserRunTimeData->xmldataOutput, parserRunTimeData->entitiesOutput};
+  const unsigned int runCount = parserRunTimeData->runs->count;
+  FILE **runFiles = malloc(sizeof(FILE*) * runCount);
+  char **rows = malloc(sizeof(char*) * runCount);
+  size_t *rowBuffers = malloc(sizeof(size_t) * runCount);
+  ssize_t *rowLengths = malloc(sizeof(ssize_t) * runCount);
+  unsigned int *keys = malloc(sizeof(unsigned int) * runCount);
+  unsigned int *heap = malloc(sizeof(unsigned int) * runCount);
+  char fileName[FILENAMELENGTH];
+  bool isMerged = true;
+
+  for (unsigned short kind = 0; kind < RUNFILES; ++kind) {
+    unsigned int heapCount = 0;
+
+    for (unsigned int i = 0; i < runCount; ++i) {
+      runFileName(fileName, i, kind);
+      runFiles[i] = fopen(fileName, "r");
+      rows[i] = NULL;
+      rowBuffers[i] = 0;
+      rowLengths[i] = runFiles[i] == NULL ? -1 : getline(&rows[i], &rowBuffers[i], runFiles[i]);
+
+      if (runFiles[i] == NULL) {
+        printf("[ ERROR ] Cannot read the sorted run \"%s\".\n", fileName);
+        isMerged = false;
+      }
+
+      if (rowLengths[i] > 0) {
+        keys[i] = readRowKey(rows[i], kind);
+        heap[heapCount] = i;
+        ++heapCount;
+      }
+    }
+
+    // Heap built by sifting down from the middle
+    for (unsigned int start = heapCount / 2; start-- > 0;) siftRunHeap(heap, keys, heapCount, start);
+
+    while (heapCount != 0) {
+      const unsigned int run = heap[0];
+
+      markOutputRow(mergeOutputs[kind], keys[run]);
+
+      // NOTE: Runs are spilled ahead of the ranking, so words get their rank here
+      if (kind == 0 && mergeOutputs[kind]->vocabulary != NULL) {
+        char *data = strrchr(rows[run], '\t') + 1;
+        data[strcspn(data, "\n")] = '\0';
+
+        appendOutput(mergeOutputs[kind], rows[run], data - rows[run]);
+        appendDecimal(mergeOutputs[kind], findVocabularyWord(mergeOutputs[kind]->vocabulary, data)->rank);
+        appendChar(mergeOutputs[kind], '\n');
+      } else appendOutput(mergeOutputs[kind], rows[run], rowLengths[run]);
+
+      rowLengths[run] = getline(&rows[run], &rowBuffers[run], runFiles[run]);
+      if (rowLengths[run] > 0) keys[run] = readRowKey(rows[run], kind);
+      else heap[0] = heap[--heapCount];
+
+      siftRunHeap(heap, keys, heapCount, 0);
+    }
+
+    for (unsigned int i = 0; i < runCount; ++i) {
+      free(rows[i]);
+      if (runFiles[i] != NULL) fclose(runFiles[i]);
+      runFileName(fileName, i, kind);
+      remove(fileName);
+    }
+  }
+
+  free(runFiles);
+  free(rows);
+  free(rowBuffers);
+  free(rowLengths);
+  free(keys);
+  free(heap);
+  return isMerged;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Writes the page index described in wickedbinary.h, the records keep
+        the order of the dump and two lists of record numbers are sorted by
+        page id and by title for binary searches.
+*/
+int comparePageIds(const void *a, const void *b) {
+  const pageOrder *pageA = (const pageOrder*) a;
+  const pageOrder *pageB = (const pageOrder*) b;
+
+  if (pageA->pageId != pageB->pageId) return pageA->pageId < pageB->pageId ? -1 : 1;
+  return pageA->record < pageB->record ? -1 : 1;
+}
+
+int comparePageTitles(const void *a, const void *b) {
+  const pageOrder *pageA = (const pageOrder*) a;
+  const pageOrder *pageB = (const pageOrder*) b;
+  int order = strcmp(pageA->title, pageB->title);
+
+  if (order != 0) return order;
+  return pageA->record < pageB->record ? -1 : 1;
+}
+
+bool writeOutPageIndex(outputBuffer **outputs, const xmlDataCollection *xmlCollection) {
+  FILE *indexFile = fopen(PAGEINDEXFILE, "wb");
+  const unsigned int pageCount = xmlCollection->pageCount;
+  pageOrder *order = NULL;
+  unsigned long long titlesLength = 0;
+  unsigned long long titleOffset = 0;
+  char fileName[WICKEDINDEXNAMESIZE];
+
+  if (indexFile == NULL) return false;
+
+  order = malloc(sizeof(pageOrder) * (pageCount + 1));
+  for (unsigned int i = 0; i < pageCount; ++i) {
+    order[i].title = xmlCollection->pages[i].title == NULL ? "" : xmlCollection->pages[i].title;
+    order[i].pageId = xmlCollection->pages[i].pageId;
+    order[i].record = i;
+    titlesLength += strlen(order[i].title) + 1;
+  }
+
+  // Pages without rows in a file start and end at its last byte
+  for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+    for (unsigned int j = outputs[i]->pageIndex; j <= pageCount; ++j) outputs[i]->pageOffsets[j] = outputs[i]->dataBytes;
+  }
+
+  fwrite(WICKEDINDEXMAGIC, 1, 4, indexFile);
+  writeBinaryUnsigned(indexFile, WICKEDINDEXVERSION, 4);
+  writeBinaryUnsigned(indexFile, pageCount, 4);
+  writeBinaryUnsigned(indexFile, OUTPUTFILES, 4);
+  writeBinaryUnsigned(indexFile, titlesLength, 8);
+
+  for (unsigned short i = 0; i < OUTPUTFILES; ++i) {
+    memset(fileName, 0, WICKEDINDEXNAMESIZE);
+    strncpy(fileName, outputs[i]->fileName, WICKEDINDEXNAMESIZE - 1);
+    fwrite(fileName, 1, WICKEDINDEXNAMESIZE, indexFile);
+  }
+
+  for (unsigned int i = 0; i < pageCount; ++i) {
+    writeBinaryUnsigned(indexFile, xmlCollection->pages[i].pageId, 4);
+    writeBinaryUnsigned(indexFile, xmlCollection->pages[i].startLine, 4);
+    writeBinaryUnsigned(indexFile, xmlCollection->pages[i].endLine, 4);
+    writeBinaryUnsigned(indexFile, titleOffset, 4);
+    titleOffset += strlen(order[i].title) + 1;
+
+    for (unsigned short j = 0; j < OUTPUTFILES; ++j) {
+      writeBinaryUnsigned(indexFile, outputs[j]->pageOffsets[i], 8);
+      writeBinaryUnsigned(indexFile, outputs[j]->pageOffsets[i + 1], 8);
+    }
+  }
+
+  qsort(order, pageCount, sizeof(pageOrder), comparePageIds);
+  for (unsigned int i = 0; i < pageCount; ++i) writeBinaryUnsigned(indexFile, order[i].record, 4);
+
+  qsort(order, pageCount, sizeof(pageOrder), comparePageTitles);
+  for (unsigned int i = 0; i < pageCount; ++i) writeBinaryUnsigned(indexFile, order[i].record, 4);
+
+  for (unsigned int i = 0; i < pageCount; ++i) {
+    const char *title = xmlCollection->pages[i].title == NULL ? "" : xmlCollection->pages[i].title;
+    fwrite(title, 1, strlen(title) + 1, indexFile);
+  }
+
+  free(order);
+  return fclose(indexFile) == 0;
+}
+
+void freeOutputShards(shardTable *shards) {
+  free(shards->startLines);
+  free(shards->firstPages);
+  shards->startLines = NULL;
+  shards->firstPages = NULL;
+  shards->count = 0;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Compresses the filled buffer into the compressed buffer of the same
+        index and returns the compressed length. Compressors keep data back,
+        so the length can be 0 until the stream is finished by "isFinal".
+*/
+unsigned int compressOutput(outputBuffer *output, const bool isFinal) {
+  #if COMPRESSWRITEOUT == COMPRESSNONE
+  return output->length;
+  #else
+  const unsigned short index = output->bufferIndex;
+  unsigned int compressedLength = 0;
+  bool isDone = false;
+
+  if (output->compressedBuffers[index] == NULL) {
+    output->compressedSize[index] = OUTPUTBUFFERSIZE + OUTPUTBUFFERSIZE / 8;
+    output->compressedBuffers[index] = malloc(sizeof(char) * output->compressedSize[index]);
+  }
+
+  z_stream *compressor = &output->compressor;
+  compressor->next_in = (unsigned char*) output->data;
+  compressor->avail_in = output->length;
+
+  while (!isDone) {
+    compressor->next_out = (unsigned char*) &output->compressedBuffers[index][compressedLength];
+    compressor->avail_out = output->compressedSize[index] - compressedLength;
+
+    int status = deflate(compressor, isFinal ? Z_FINISH : Z_NO_FLUSH);
+    compressedLength = output->compressedSize[index] - compressor->avail_out;
+
+    if (status == Z_STREAM_ERROR) {
+      output->hasFailed = true;
+      isDone = true;
+    } else if (isFinal) isDone = status == Z_STREAM_END;
+    else isDone = compressor->avail_in == 0 && compressor->avail_out != 0;
+
+    if (!isDone && compressedLength == output->compressedSize[index]) {
+      output->compressedSize[index] *= 2;
+      output->compressedBuffers[index] = (char*) realloc(output->compressedBuffers[index], sizeof(char) * output->compressedSize[index]);
+    }
+  }
+
+  return compressedLength;
+  #endif
+}
+
+//------------------------------------------------------------------------------
+
+void reportOutputBuffer(const outputBuffer *output) {
+  if (output->fileDescriptor == -1 && output->shards == NULL) return;
+
+  if (COMPRESSWRITEOUT == COMPRESSNONE) {
+    printf("[REPORT] %-24s : %.3lf MB\n", output->fileName, output->dataBytes / 1000000.0);
+  } else {
+    printf("[REPORT] %-24s : %.3lf MB UNCOMPRESSED | %.3lf MB COMPRESSED | RATIO %.2lf\n", output->fileName, output->dataBytes / 1000000.0, output->writtenBytes / 1000000.0, output->writtenBytes == 0 ? 0.0 : (double) output->dataBytes / output->writtenBytes);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+bool initAsyncWriter(asyncWriter *writer) {
+  writer->hasFailed = false;
+  writer->isStopping = false;
+  writer->queueHead = 0;
+  writer->queueCount = 0;
+
+  for (unsigned int i = 0; i < ASYNCQUEUESIZE; ++i) writer->queue[i].isPending = NULL;
+
+  writer->isRing = initWriteRing(writer);
+  if (writer->isRing) return true;
+
+  pthread_mutex_init(&writer->lock, NULL);
+  pthread_cond_init(&writer->wake, NULL);
+  pthread_cond_init(&writer->done, NULL);
+
+  if (pthread_create(&writer->thread, NULL, asyncWriteThread, writer) != 0) {
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->wake);
+    pthread_cond_destroy(&writer->done);
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Sets up the submission and completion rings of io_uring by the plain
+        system calls, returns false when io_uring is not available.
+*/
+bool initWriteRing(asyncWriter *writer) {
+  #if defined(__linux__) && defined(__NR_io_uring_setup)
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  writer->ringDescriptor = syscall(__NR_io_uring_setup, ASYNCQUEUESIZE, &params);
+  if (writer->ringDescriptor < 0) return false;
+
+  writer->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+  writer->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  writer->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  writer->sqRing = mmap(NULL, writer->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED, writer->ringDescriptor, IORING_OFF_SQ_RING);
+  writer->cqRing = mmap(NULL, writer->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED, writer->ringDescriptor, IORING_OFF_CQ_RING);
+  writer->sqes = mmap(NULL, writer->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED, writer->ringDescriptor, IORING_OFF_SQES);
+
+  if (writer->sqRing == MAP_FAILED || writer->cqRing == MAP_FAILED || writer->sqes == MAP_FAILED) {
+    if (writer->sqRing != MAP_FAILED) munmap(writer->sqRing, writer->sqRingSize);
+    if (writer->cqRing != MAP_FAILED) munmap(writer->cqRing, writer->cqRingSize);
+    if (writer->sqes != MAP_FAILED) munmap(writer->sqes, writer->sqesSize);
+    close(writer->ringDescriptor);
+    return false;
+  }
+
+  writer->sqTail = (unsigned int*) ((char*) writer->sqRing + params.sq_off.tail);
+  writer->sqMask = (unsigned int*) ((char*) writer->sqRing + params.sq_off.ring_mask);
+  writer->sqArray = (unsigned int*) ((char*) writer->sqRing + params.sq_off.array);
+  writer->cqHead = (unsigned int*) ((char*) writer->cqRing + params.cq_off.head);
+  writer->cqTail = (unsigned int*) ((char*) writer->cqRing + params.cq_off.tail);
+  writer->cqMask = (unsigned int*) ((char*) writer->cqRing + params.cq_off.ring_mask);
+  writer->cqes = (struct io_uring_cqe*) ((char*) writer->cqRing + params.cq_off.cqes);
+
+  return true;
+  #else
+  return false;
+  #endif
+}
+
+//------------------------------------------------------------------------------
+
+void submitAsyncWrite(asyncWriter *writer, const int fileDescriptor, const char *data, const unsigned int dataLength, const unsigned long long offset, bool *isPending) {
+  if (writer->isRing) {
+    #if defined(__linux__) && defined(__NR_io_uring_setup)
+    unsigned int slot = 0;
+
+    // NOTE: Each output waits for its buffers, so there is always a free slot
+    while (writer->queue[slot].isPending != NULL) {
+      if (++slot == ASYNCQUEUESIZE) {
+        reapWriteRing(writer);
+        slot = 0;
+      }
+    }
+
+    writer->queue[slot] = (asyncWrite) {fileDescriptor, dataLength, offset, data, isPending};
+    *isPending = true;
+
+    unsigned int tail = *writer->sqTail;
+    unsigned int index = tail & *writer->sqMask;
+    struct io_uring_sqe *sqe = &writer->sqes[index];
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fileDescriptor;
+    sqe->addr = (unsigned long) data;
+    sqe->len = dataLength;
+    sqe->off = offset;
+    sqe->user_data = slot;
+    writer->sqArray[index] = index;
+    __atomic_store_n(writer->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    if (syscall(__NR_io_uring_enter, writer->ringDescriptor, 1, 0, 0, NULL, 0) < 0) {
+      // NOTE: The submission is taken back and written right away
+      __atomic_store_n(writer->sqTail, tail, __ATOMIC_RELEASE);
+      if (!writeOutputData(fileDescriptor, data, dataLength, offset)) writer->hasFailed = true;
+      writer->queue[slot].isPending = NULL;
+      *isPending = false;
+    }
+    #endif
+    return;
+  }
+
+  pthread_mutex_lock(&writer->lock);
+  while (writer->queueCount == ASYNCQUEUESIZE) pthread_cond_wait(&writer->done, &writer->lock);
+
+  writer->queue[(writer->queueHead + writer->queueCount) % ASYNCQUEUESIZE] = (asyncWrite) {fileDescriptor, dataLength, offset, data, isPending};
+  ++writer->queueCount;
+  *isPending = true;
+
+  pthread_cond_signal(&writer->wake);
+  pthread_mutex_unlock(&writer->lock);
+}
+
+//------------------------------------------------------------------------------
+
+void waitAsyncWrite(asyncWriter *writer, bool *isPending) {
+  if (writer->isRing) {
+    while (*isPending) reapWriteRing(writer);
+    return;
+  }
+
+  pthread_mutex_lock(&writer->lock);
+  while (*isPending) pthread_cond_wait(&writer->done, &writer->lock);
+  pthread_mutex_unlock(&writer->lock);
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Waits for at least one completion and takes in all finished writes,
+        short writes are completed by pwrite.
+*/
+void reapWriteRing(asyncWriter *writer) {
+  #if defined(__linux__) && defined(__NR_io_uring_setup)
+  unsigned int head = *writer->cqHead;
+
+  if (head == __atomic_load_n(writer->cqTail, __ATOMIC_ACQUIRE)) {
+    syscall(__NR_io_uring_enter, writer->ringDescriptor, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+  }
+
+  while (head != __atomic_load_n(writer->cqTail, __ATOMIC_ACQUIRE)) {
+    struct io_uring_cqe *cqe = &writer->cqes[head & *writer->cqMask];
+    asyncWrite *pendingWrite = &writer->queue[cqe->user_data];
+    unsigned int written = cqe->res < 0 ? 0 : cqe->res;
+
+    if (written < pendingWrite->length && !writeOutputData(pendingWrite->fileDescriptor, &pendingWrite->data[written], pendingWrite->length - written, pendingWrite->offset + written)) {
+      writer->hasFailed = true;
+    }
+
+    *pendingWrite->isPending = false;
+    pendingWrite->isPending = NULL;
+    ++head;
+  }
+
+  __atomic_store_n(writer->cqHead, head, __ATOMIC_RELEASE);
+  #endif
+}
+
+//------------------------------------------------------------------------------
+
+void* asyncWriteThread(void *data) {
+  asyncWriter *writer = data;
+  asyncWrite pendingWrite;
+  bool isWritten = false;
+
+  pthread_mutex_lock(&writer->lock);
+
+  while (true) {
+    while (writer->queueCount == 0 && !writer->isStopping) pthread_cond_wait(&writer->wake, &writer->lock);
+    if (writer->queueCount == 0) break;
+
+    pendingWrite = writer->queue[writer->queueHead];
+    writer->queueHead = (writer->queueHead + 1) % ASYNCQUEUESIZE;
+    --writer->queueCount;
+
+    pthread_mutex_unlock(&writer->lock);
+    isWritten = writeOutputData(pendingWrite.fileDescriptor, pendingWrite.data, pendingWrite.length, pendingWrite.offset);
+    pthread_mutex_lock(&writer->lock);
+
+    if (!isWritten) writer->hasFailed = true;
+    *pendingWrite.isPending = false;
+    pthread_cond_broadcast(&writer->done);
+  }
+
+  pthread_mutex_unlock(&writer->lock);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+
+void closeAsyncWriter(asyncWriter *writer) {
+  if (writer->isRing) {
+    #if defined(__linux__) && defined(__NR_io_uring_setup)
+    for (unsigned int i = 0; i < ASYNCQUEUESIZE; ++i) {
+      if (writer->queue[i].isPending != NULL) waitAsyncWrite(writer, writer->queue[i].isPending);
+    }
+
+    munmap(writer->sqes, writer->sqesSize);
+    munmap(writer->cqRing, writer->cqRingSize);
+    munmap(writer->sqRing, writer->sqRingSize);
+    close(writer->ringDescriptor);
+    #endif
+    return;
+  }
+
+  pthread_mutex_lock(&writer->lock);
+  writer->isStopping = true;
+  pthread_cond_signal(&writer->wake);
+  pthread_mutex_unlock(&writer->lock);
+
+  pthread_join(writer->thread, NULL);
+  pthread_mutex_destroy(&writer->lock);
+  pthread_cond_destroy(&writer->wake);
+  pthread_cond_destroy(&writer->done);
+}
+
+//------------------------------------------------------------------------------
+
+// NOTE: The format bits are left out with FORMATSPANS, as the format columns
+static inline unsigned char binaryFlags(const bool formatStart, const bool formatEnd, const bool hasPipe) {
+  if (FORMATSPANS) return hasPipe ? WICKEDHASPIPE : 0;
+  return (formatStart ? WICKEDFORMATSTART : 0) | (formatEnd ? WICKEDFORMATEND : 0) | (hasPipe ? WICKEDHASPIPE : 0);
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Writes the collection as binary columns, one file per token kind. The
+        rows are in collection order, tokens of wikitags follow their wikitag
+        and hold its position as parent.
+*/
+bool writeOutBinaryFiles(const struct parserBaseStore* parserRunTimeData, struct xmlDataCollection* xmlCollection) {
+  const unsigned char tokenTypes[WICKEDTOKENCOLUMNS] = {WICKEDDELTA, WICKEDDELTA, WICKEDVARINT, WICKEDVARINT, WICKEDVARINT, WICKEDFIXED, WICKEDSTRING, WICKEDFIXED, WICKEDFIXED};
+  const unsigned char tokenWidths[WICKEDTOKENCOLUMNS] = {0, 0, 0, 0, 0, 1, 0, 1, 1};
+  const unsigned char tagTypes[WICKEDTAGCOLUMNS] = {WICKEDDELTA, WICKEDDELTA, WICKEDVARINT, WICKEDVARINT, WICKEDVARINT, WICKEDFIXED, WICKEDFIXED, WICKEDVARINT, WICKEDSTRING, WICKEDFIXED, WICKEDFIXED};
+  const unsigned char tagWidths[WICKEDTAGCOLUMNS] = {0, 0, 0, 0, 0, 2, 1, 0, 0, 1, 1};
+  const unsigned char xmlTypes[WICKEDXMLCOLUMNS] = {WICKEDDELTA, WICKEDDELTA, WICKEDFIXED, WICKEDFIXED, WICKEDSTRING};
+  const unsigned char xmlWidths[WICKEDXMLCOLUMNS] = {0, 0, 2, 1, 0};
+  const unsigned char pairTypes[WICKEDKEYCOLUMNS] = {WICKEDDELTA, WICKEDDELTA, WICKEDSTRING, WICKEDSTRING};
+  const unsigned char pairWidths[WICKEDKEYCOLUMNS] = {0, 0, 0, 0};
+
+  // NOTE: With FORMATSPANS the tables end before the format columns
+  const unsigned int tokenColumns = FORMATSPANS ? WICKEDTOKENBASECOLUMNS : WICKEDTOKENCOLUMNS;
+  const unsigned int tagColumns = FORMATSPANS ? WICKEDTAGBASECOLUMNS : WICKEDTAGCOLUMNS;
+
+  binaryTable words, entities, wikiTags, xmlTags, xmlData, redirects;
+  initBinaryTable(&words, WICKEDKINDWORDS, tokenColumns, tokenTypes, tokenWidths);
+  initBinaryTable(&entities, WICKEDKINDENTITIES, tokenColumns, tokenTypes, tokenWidths);
+  initBinaryTable(&wikiTags, WICKEDKINDWIKITAGS, tagColumns, tagTypes, tagWidths);
+  initBinaryTable(&xmlTags, WICKEDKINDXMLTAGS, WICKEDXMLCOLUMNS, xmlTypes, xmlWidths);
+  initBinaryTable(&xmlData, WICKEDKINDXMLDATA, WICKEDKEYCOLUMNS, pairTypes, pairWidths);
+  initBinaryTable(&redirects, WICKEDKINDREDIRECTS, WICKEDREDIRECTCOLUMNS, pairTypes, pairWidths);
+
+  struct xmlNode *xmlTag = NULL;
+
+  for (unsigned int i = 0; i < xmlCollection->count; ++i) {
+    xmlTag = &xmlCollection->nodes[i];
+
+    addBinaryValue(&xmlTags, WICKEDXMLSTART, xmlTag->start);
+    addBinaryValue(&xmlTags, WICKEDXMLEND, xmlTag->end);
+    addBinaryValue(&xmlTags, WICKEDXMLINDENT, xmlTag->indent);
+    addBinaryValue(&xmlTags, WICKEDXMLFLAGS, (xmlTag->isClosed ? WICKEDISCLOSED : 0) | (xmlTag->isDataNode ? WICKEDISDATANODE : 0));
+    addBinaryString(&xmlTags, WICKEDXMLNAME, xmlTag->name);
+    ++xmlTags.rowCount;
+
+    for (unsigned int j = 0; j < xmlTag->keyValuePairs; ++j) {
+      addBinaryValue(&xmlData, WICKEDKEYSTART, xmlTag->start);
+      addBinaryValue(&xmlData, WICKEDKEYEND, xmlTag->end);
+      addBinaryString(&xmlData, WICKEDKEYKEY, xmlTag->keyValues[j].key);
+      addBinaryString(&xmlData, WICKEDKEYVALUE, xmlTag->keyValues[j].value);
+      ++xmlData.rowCount;
+    }
+
+    for (unsigned int j = 0; j < xmlTag->wordCount; ++j) addBinaryWord(&words, &xmlTag->words[j], -1);
+    for (unsigned int j = 0; j < xmlTag->entityCount; ++j) addBinaryEntity(&entities, &xmlTag->entities[j], -1);
+    for (unsigned int j = 0; j < xmlTag->wTagCount; ++j) writeOutBinaryTag(&wikiTags, &words, &entities, parserRunTimeData->targets, &xmlTag->wikiTags[j], -1);
+  }
+
+  for (unsigned int i = 0; i < xmlCollection->redirectCount; ++i) {
+    addBinaryValue(&redirects, WICKEDREDIRECTPAGEID, xmlCollection->redirects[i].pageId);
+    addBinaryValue(&redirects, WICKEDREDIRECTLINE, xmlCollection->redirects[i].lineNum);
+    addBinaryString(&redirects, WICKEDREDIRECTTITLE, xmlCollection->redirects[i].title);
+    addBinaryString(&redirects, WICKEDREDIRECTTARGET, xmlCollection->redirects[i].target);
+    ++redirects.rowCount;
+  }
+
+  bool isWritten = writeBinaryTable(parserRunTimeData->dictFile, &words);
+  isWritten &= writeBinaryTable(parserRunTimeData->entitiesFile, &entities);
+  isWritten &= writeBinaryTable(parserRunTimeData->wtagFile, &wikiTags);
+  isWritten &= writeBinaryTable(parserRunTimeData->xmltagFile, &xmlTags);
+  isWritten &= writeBinaryTable(parserRunTimeData->xmldataFile, &xmlData);
+  if (!writeBinaryTable(parserRunTimeData->redirectsFile, &redirects) && REDIRECTTABLE) isWritten = false;
+
+  return isWritten;
+}
+
+//------------------------------------------------------------------------------
+
+void writeOutBinaryTag(binaryTable *wikiTags, binaryTable *words, binaryTable *entities, const targetTable *targets, const wikiTag *wTag, const int parent) {
+  addBinaryValue(wikiTags, WICKEDTAGPOSITION, wTag->position);
+  addBinaryValue(wikiTags, WICKEDTAGLINE, wTag->lineNum);
+  addBinaryValue(wikiTags, WICKEDTAGPARENT, parent);
+  addBinaryValue(wikiTags, WICKEDTAGPRESPACES, wTag->preSpacesCount);
+  addBinaryValue(wikiTags, WICKEDTAGSPACES, wTag->spacesCount);
+  addBinaryValue(wikiTags, WICKEDTAGTYPE, wTag->tagType);
+  addBinaryValue(wikiTags, WICKEDTAGFLAGS, binaryFlags(wTag->formatStart, wTag->formatEnd, wTag->hasPipe));
+  addBinaryValue(wikiTags, WICKEDTAGLENGTH, wTag->tagLength);
+  addBinaryString(wikiTags, WICKEDTAGTARGET, targets->data[wTag->target]);
+  if (!FORMATSPANS) {
+    addBinaryValue(wikiTags, WICKEDTAGDATAFORMAT, wTag->dataFormatType);
+    addBinaryValue(wikiTags, WICKEDTAGOWNFORMAT, wTag->ownFormatType);
+  }
+  ++wikiTags->rowCount;
+
+  for (unsigned int k = 0; k < wTag->wordCount; ++k) {
+    word wordElement = wTag->pipedWords[k];
+    shiftSharedChild(wTag, &wordElement.position, &wordElement.lineNum);
+    addBinaryWord(words, &wordElement, wTag->position);
+  }
+
+  for (unsigned int k = 0; k < wTag->entityCount; ++k) {
+    entity entityElement = wTag->pipedEntities[k];
+    shiftSharedChild(wTag, &entityElement.position, &entityElement.lineNum);
+    addBinaryEntity(entities, &entityElement, wTag->position);
+  }
+
+  for (unsigned int k = 0; k < wTag->wTagCount; ++k) {
+    wikiTag wikiTagElement = wTag->pipedTags[k];
+    shiftSharedChild(wTag, &wikiTagElement.position, &wikiTagElement.lineNum);
+    writeOutBinaryTag(wikiTags, words, entities, targets, &wikiTagElement, wTag->position);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void addBinaryWord(binaryTable *table, const word *wordElement, const int parent) {
+  addBinaryValue(table, WICKEDTOKENPOSITION, wordElement->position);
+  addBinaryValue(table, WICKEDTOKENLINE, wordElement->lineNum);
+  addBinaryValue(table, WICKEDTOKENPARENT, parent);
+  addBinaryValue(table, WICKEDTOKENPRESPACES, wordElement->preSpacesCount);
+  addBinaryValue(table, WICKEDTOKENSPACES, wordElement->spacesCount);
+  addBinaryValue(table, WICKEDTOKENFLAGS, binaryFlags(wordElement->formatStart, wordElement->formatEnd, wordElement->hasPipe));
+  addBinaryString(table, WICKEDTOKENDATA, wordElement->data);
+  if (!FORMATSPANS) {
+    addBinaryValue(table, WICKEDTOKENDATAFORMAT, wordElement->dataFormatType);
+    addBinaryValue(table, WICKEDTOKENOWNFORMAT, wordElement->ownFormatType);
+  }
+  ++table->rowCount;
+}
+
+void addBinaryEntity(binaryTable *table, const entity *entityElement, const int parent) {
+  addBinaryValue(table, WICKEDTOKENPOSITION, entityElement->position);
+  addBinaryValue(table, WICKEDTOKENLINE, entityElement->lineNum);
+  addBinaryValue(table, WICKEDTOKENPARENT, parent);
+  addBinaryValue(table, WICKEDTOKENPRESPACES, entityElement->preSpacesCount);
+  addBinaryValue(table, WICKEDTOKENSPACES, entityElement->spacesCount);
+  addBinaryValue(table, WICKEDTOKENFLAGS, binaryFlags(entityElement->formatStart, entityElement->formatEnd, entityElement->hasPipe));
+  addBinaryString(table, WICKEDTOKENDATA, entityElement->data);
+  if (!FORMATSPANS) {
+    addBinaryValue(table, WICKEDTOKENDATAFORMAT, entityElement->dataFormatType);
+    addBinaryValue(table, WICKEDTOKENOWNFORMAT, entityElement->ownFormatType);
+  }
+  ++table->rowCount;
+}
+
+//------------------------------------------------------------------------------
+
+void initBinaryTable(binaryTable *table, const unsigned int kind, const unsigned int columnCount, const unsigned char *types, const unsigned char *widths) {
+  table->kind = kind;
+  table->rowCount = 0;
+  table->columnCount = columnCount;
+
+  for (unsigned int i = 0; i < columnCount; ++i) {
+    table->columns[i] = (binaryColumn) {types[i], widths[i], false, 0, 0, 0, 0, NULL, NULL};
+  }
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Makes room for "length" bytes. A column which cannot grow any further
+        is marked as failed and its table is not written.
+*/
+bool growBinaryColumn(binaryColumn *column, const size_t length) {
+  if (column->hasFailed) return false;
+  if (column->length + length <= column->bufferSize) return true;
+
+  size_t bufferSize = column->bufferSize == 0 ? LINEBUFFERBASE : column->bufferSize;
+  unsigned char *data = NULL;
+
+  if (length <= SIZE_MAX - column->length) {
+    while (column->length + length > bufferSize && bufferSize <= SIZE_MAX / 2) bufferSize *= 2;
+    if (column->length + length <= bufferSize) data = (unsigned char*) realloc(column->data, sizeof(unsigned char) * bufferSize);
+  }
+
+  if (data == NULL) {
+    printf("[ ERROR ] Cannot grow a binary column of %zu bytes by %zu bytes, its table is not written.\n", column->length, length);
+    column->hasFailed = true;
+    return false;
+  }
+
+  column->data = data;
+  column->bufferSize = bufferSize;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Adds the value of the current row, "rowCount" is raised by the caller
+        once all columns of the row are added.
+*/
+void addBinaryValue(binaryTable *table, const unsigned int columnIndex, const long long value) {
+  binaryColumn *column = &table->columns[columnIndex];
+  unsigned long long zigzag = 0;
+
+  if (column->type == WICKEDFIXED) {
+    if (!growBinaryColumn(column, column->width)) return;
+    for (unsigned short i = 0; i < column->width; ++i) column->data[column->length++] = (unsigned long long) value >> (8 * i);
+    return;
+  }
+
+  if (column->type == WICKEDDELTA) {
+    zigzag = value - column->lastValue;
+    column->lastValue = value;
+  } else zigzag = value;
+
+  zigzag = (zigzag << 1) ^ -(zigzag >> 63);
+
+  if (!growBinaryColumn(column, 10)) return;
+  while (zigzag >= 0x80) {
+    column->data[column->length++] = (zigzag & 0x7F) | 0x80;
+    zigzag >>= 7;
+  }
+  column->data[column->length++] = zigzag;
+}
+
+//------------------------------------------------------------------------------
+
+void addBinaryString(binaryTable *table, const unsigned int columnIndex, const char *data) {
+  binaryColumn *column = &table->columns[columnIndex];
+  size_t dataLength = data == NULL ? 0 : strlen(data);
+
+  if (!growBinaryColumn(column, dataLength + 1)) return;
+
+  if (table->rowCount >= column->offsetBuffer) {
+    column->offsetBuffer = column->offsetBuffer == 0 ? LINEBUFFERBASE : column->offsetBuffer * 2;
+    column->stringOffsets = (unsigned long long*) realloc(column->stringOffsets, sizeof(unsigned long long) * column->offsetBuffer);
+  }
+
+  column->stringOffsets[table->rowCount] = column->length;
+  if (dataLength != 0) memcpy(&column->data[column->length], data, dataLength);
+  column->length += dataLength;
+  column->data[column->length++] = '\0';
+}
+
+//------------------------------------------------------------------------------
+
+void writeBinaryUnsigned(FILE *outputFile, unsigned long long value, const unsigned short width) {
+  unsigned char bytes[8];
+
+  for (unsigned short i = 0; i < width; ++i) {
+    bytes[i] = value & 0xFF;
+    value >>= 8;
+  }
+
+  fwrite(bytes, 1, width, outputFile);
+}
+
+/*
+  NOTE: Writes header, column directory and columns to the file and frees the
+        column buffers of the table.
+*/
+bool writeBinaryTable(FILE *outputFile, binaryTable *table) {
+  unsigned long long offset = WICKEDHEADERSIZE + table->columnCount * WICKEDCOLUMNENTRYSIZE;
+  unsigned long long columnLength = 0;
+  binaryColumn *column = NULL;
+
+  bool hasFailed = outputFile == NULL;
+  for (unsigned int i = 0; i < table->columnCount; ++i) hasFailed |= table->columns[i].hasFailed;
+
+  if (hasFailed) {
+    for (unsigned int i = 0; i < table->columnCount; ++i) {
+      free(table->columns[i].data);
+      free(table->columns[i].stringOffsets);
+    }
+
+    return false;
+  }
+
+  fwrite(WICKEDMAGIC, sizeof(char), 4, outputFile);
+  writeBinaryUnsigned(outputFile, WICKEDVERSION, 4);
+  writeBinaryUnsigned(outputFile, table->kind, 4);
+  writeBinaryUnsigned(outputFile, table->rowCount, 4);
+  writeBinaryUnsigned(outputFile, table->columnCount, 4);
+
+  for (unsigned int i = 0; i < table->columnCount; ++i) {
+    column = &table->columns[i];
+    columnLength = column->length;
+    if (column->type == WICKEDSTRING) columnLength += (table->rowCount + 1) * 8ULL;
+
+    offset = (offset + 7) & ~7ULL;
+    fputc(column->type, outputFile);
+    fputc(column->width, outputFile);
+    writeBinaryUnsigned(outputFile, 0, 6);
+    writeBinaryUnsigned(outputFile, offset, 8);
+    writeBinaryUnsigned(outputFile, columnLength, 8);
+    offset += columnLength;
+  }
+
+  offset = WICKEDHEADERSIZE + table->columnCount * WICKEDCOLUMNENTRYSIZE;
+
+  for (unsigned int i = 0; i < table->columnCount; ++i) {
+    column = &table->columns[i];
+
+    while (offset % 8 != 0) {
+      fputc(0, outputFile);
+      ++offset;
+    }
+
+    if (column->type == WICKEDSTRING) {
+      for (unsigned int j = 0; j < table->rowCount; ++j) writeBinaryUnsigned(outputFile, column->stringOffsets[j], 8);
+      writeBinaryUnsigned(outputFile, column->length, 8);
+      offset += (table->rowCount + 1) * 8ULL;
+    }
+
+    if (column->length != 0) fwrite(column->data, sizeof(unsigned char), column->length, outputFile);
+    offset += column->length;
+
+    free(column->data);
+    free(column->stringOffsets);
+  }
+
+  return ferror(outputFile) == 0;
+}
+
+//------------------------------------------------------------------------------
+
+void freeXMLCollection(xmlDataCollection *xmlCollection) {
+  for (unsigned int i = 0; i < xmlCollection->count; ++i) freeXMLNode(&xmlCollection->nodes[i]);
+
+  for (unsigned int i = 0; i < xmlCollection->redirectCount; ++i) {
+    free(xmlCollection->redirects[i].title);
+    free(xmlCollection->redirects[i].target);
+  }
+
+  free(xmlCollection->nodes);
+  free(xmlCollection->openNodes);
+  free(xmlCollection->redirects);
+
+  for (unsigned int i = 0; i < xmlCollection->pageCount; ++i) free(xmlCollection->pages[i].title);
+  free(xmlCollection->pages);
+
+  #if DEBUG
+  printf("[DEBUG] Successfully cleaned up xmlCollection...\n");
+  #endif
+
+  return;
+}
+
+void freeXMLCollectionTag(wikiTag *wTag) {
+  // NOTE: Shared children are freed with their canonical copy
+  if (wTag->shared != NULL) return;
+
+  for (unsigned int i = 0; i < wTag->wordCount; ++i) {
+    free(wTag->pipedWords[i].data);
+  }
+
+  for (unsigned int i = 0; i < wTag->wTagCount; ++i) {
+    freeXMLCollectionTag(&wTag->pipedTags[i]);
+  }
+
+  free(wTag->pipedWords);
+  free(wTag->pipedTags);
+  free(wTag->pipedEntities);
+
+  return;
+}
+
+void freeXMLNode(xmlNode *xmlTag) {
+  for (unsigned int j = 0; j < xmlTag->keyValuePairs; ++j) {
+    free(xmlTag->keyValues[j].key);
+    free(xmlTag->keyValues[j].value);
+  }
+
+  freeXMLNodeTokens(xmlTag);
+
+  free(xmlTag->name);
+  free(xmlTag->keyValues);
+}
+
+// NOTE: Frees the words, entities and wikitags of the node, the node keeps none
+void freeXMLNodeTokens(xmlNode *xmlTag) {
+  for (unsigned int j = 0; j < xmlTag->wordCount; ++j) free(xmlTag->words[j].data);
+  for (unsigned int j = 0; j < xmlTag->wTagCount; ++j) freeXMLCollectionTag(&xmlTag->wikiTags[j]);
+
+  free(xmlTag->words);
+  free(xmlTag->entities);
+  free(xmlTag->wikiTags);
+  xmlTag->words = NULL;
+  xmlTag->entities = NULL;
+  xmlTag->wikiTags = NULL;
+  xmlTag->wordCount = 0;
+  xmlTag->entityCount = 0;
+  xmlTag->wTagCount = 0;
+  xmlTag->firstAddedType = -1;
+  xmlTag->lastAddedType = -1;
 }
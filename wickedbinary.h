@@ -0,0 +1,401 @@
+//------------------------------------------------------------------------------
+// Author: Jan Riechers <jan@dwrox.net>
+//------------------------------------------------------------------------------
+#ifndef WICKEDBINARY_H
+#define WICKEDBINARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Binary columnar output of wicked, one file per token kind.
+
+        File layout (little endian):
+        4 bytes magic "WKDB"
+        4 bytes version
+        4 bytes kind (WICKEDKIND...)
+        4 bytes row count
+        4 bytes column count
+        per column 24 bytes: 1 byte type, 1 byte width, 6 bytes padding,
+                             8 bytes data offset, 8 bytes data length
+        column data, each column starts 8 byte aligned
+
+        Column types:
+        WICKEDFIXED  => "width" bytes per row, signed
+        WICKEDVARINT => zigzag varint per row
+        WICKEDDELTA  => zigzag varint of the difference to the previous row
+        WICKEDSTRING => (row count + 1) 8 byte offsets into the string heap
+                        following them, each string is '\0' terminated
+
+        The format columns are the last ones of words, entities and wikitags.
+        Written with FORMATSPANS the tables end before them, their column count
+        is WICKED...BASECOLUMNS, and the flags hold no format bits.
+*/
+#define WICKEDMAGIC "WKDB"
+#define WICKEDVERSION 3
+#define WICKEDHEADERSIZE 20
+#define WICKEDCOLUMNENTRYSIZE 24
+#define WICKEDMAXCOLUMNS 12
+
+#define WICKEDFIXED 0
+#define WICKEDVARINT 1
+#define WICKEDDELTA 2
+#define WICKEDSTRING 3
+
+// Kinds of files
+#define WICKEDKINDWORDS 0
+#define WICKEDKINDENTITIES 1
+#define WICKEDKINDWIKITAGS 2
+#define WICKEDKINDXMLTAGS 3
+#define WICKEDKINDXMLDATA 4
+#define WICKEDKINDREDIRECTS 5
+
+// Flags column bits
+#define WICKEDFORMATSTART 1
+#define WICKEDFORMATEND 2
+#define WICKEDHASPIPE 4
+#define WICKEDISCLOSED 1
+#define WICKEDISDATANODE 2
+
+// Columns of words and entities
+#define WICKEDTOKENPOSITION 0
+#define WICKEDTOKENLINE 1
+#define WICKEDTOKENPARENT 2
+#define WICKEDTOKENPRESPACES 3
+#define WICKEDTOKENSPACES 4
+#define WICKEDTOKENFLAGS 5
+#define WICKEDTOKENDATA 6
+#define WICKEDTOKENBASECOLUMNS 7
+#define WICKEDTOKENDATAFORMAT 7
+#define WICKEDTOKENOWNFORMAT 8
+#define WICKEDTOKENCOLUMNS 9
+
+// Columns of wikitags
+#define WICKEDTAGPOSITION 0
+#define WICKEDTAGLINE 1
+#define WICKEDTAGPARENT 2
+#define WICKEDTAGPRESPACES 3
+#define WICKEDTAGSPACES 4
+#define WICKEDTAGTYPE 5
+#define WICKEDTAGFLAGS 6
+#define WICKEDTAGLENGTH 7
+#define WICKEDTAGTARGET 8
+#define WICKEDTAGBASECOLUMNS 9
+#define WICKEDTAGDATAFORMAT 9
+#define WICKEDTAGOWNFORMAT 10
+#define WICKEDTAGCOLUMNS 11
+
+// Columns of xml tags
+#define WICKEDXMLSTART 0
+#define WICKEDXMLEND 1
+#define WICKEDXMLINDENT 2
+#define WICKEDXMLFLAGS 3
+#define WICKEDXMLNAME 4
+#define WICKEDXMLCOLUMNS 5
+
+// Columns of xml key/values
+#define WICKEDKEYSTART 0
+#define WICKEDKEYEND 1
+#define WICKEDKEYKEY 2
+#define WICKEDKEYVALUE 3
+#define WICKEDKEYCOLUMNS 4
+
+// Columns of redirects
+#define WICKEDREDIRECTPAGEID 0
+#define WICKEDREDIRECTLINE 1
+#define WICKEDREDIRECTTITLE 2
+#define WICKEDREDIRECTTARGET 3
+#define WICKEDREDIRECTCOLUMNS 4
+
+/*
+  NOTE: Page index of the text write out, maps pages to their lines and the
+        bytes of their rows in each uncompressed text file.
+
+        File layout (little endian):
+        4 bytes magic "WKDI"
+        4 bytes version
+        4 bytes page count
+        4 bytes file count
+        8 bytes title heap length
+        per file 32 bytes file name, '\0' padded
+        per page 16 + 16 * file count bytes: 4 bytes page id, 4 bytes first
+                 line, 4 bytes last line, 4 bytes title offset and per file
+                 8 bytes first byte, 8 bytes end byte
+        page count * 4 bytes record numbers sorted by page id
+        page count * 4 bytes record numbers sorted by title (bytewise)
+        title heap, each title is '\0' terminated
+*/
+#define WICKEDINDEXMAGIC "WKDI"
+#define WICKEDINDEXVERSION 1
+#define WICKEDINDEXHEADERSIZE 24
+#define WICKEDINDEXNAMESIZE 32
+#define WICKEDINDEXMAXFILES 8
+
+/*
+  NOTE: Vocabulary, the distinct words sorted bytewise and front coded in
+        blocks. The id of a word is its place in the sorted order.
+
+        File layout (little endian):
+        4 bytes magic "WKDV"
+        4 bytes version
+        4 bytes word count
+        4 bytes words per block
+        4 bytes block count
+        4 bytes padding
+        8 bytes data length
+        block count * 8 bytes offset of each block in the data
+        data, per block the first word as varint length and bytes, each
+        following word as varint length of the prefix shared with the word
+        before, varint length and bytes of the rest
+*/
+#define WICKEDVOCABULARYMAGIC "WKDV"
+#define WICKEDVOCABULARYVERSION 1
+#define WICKEDVOCABULARYHEADERSIZE 32
+
+/*
+  NOTE: Inverted index, the postings of each word of the vocabulary. Terms are
+        sorted as in the vocabulary, the index of a term is its word id.
+
+        File layout (little endian):
+        4 bytes magic "WKDP"
+        4 bytes version
+        4 bytes term count
+        4 bytes padding
+        8 bytes term heap length
+        8 bytes postings length
+        per term 24 bytes: 8 bytes postings offset, 4 bytes postings length,
+                           4 bytes posting count, 4 bytes page count,
+                           4 bytes term offset
+        term heap, each term is '\0' terminated
+        postings, 8 byte aligned, per posting varint of the page id minus
+        the page id before and varint of the position of the word in the
+        page, minus the position before if the page id is the same. Both
+        differences are taken modulo 2^32.
+*/
+#define WICKEDPOSTINGSMAGIC "WKDP"
+#define WICKEDPOSTINGSVERSION 1
+#define WICKEDPOSTINGSHEADERSIZE 32
+#define WICKEDTERMENTRYSIZE 24
+
+/*
+  NOTE: Link graph of the "Link" wikitags in compressed sparse row form. The
+        pages are the nodes, numbered by their record in dump order.
+
+        File layout (little endian):
+        4 bytes magic "WKDG"
+        4 bytes version
+        4 bytes page count
+        4 bytes count of the unresolved links
+        8 bytes link count
+        (page count + 1) * 8 bytes offsets, the links of a page are the
+        targets from its offset up to the offset of the next page
+        page count * 4 bytes page ids
+        link count * 4 bytes target page records, in the order of the links
+        on their page
+        page count * 4 bytes page records sorted by page id, dump order for
+        page ids given twice
+*/
+#define WICKEDGRAPHMAGIC "WKDG"
+#define WICKEDGRAPHVERSION 2
+#define WICKEDGRAPHHEADERSIZE 24
+
+/*
+  NOTE: Metadata of the pages, one column after the other, the pages are
+        numbered by their record in dump order as for the link graph.
+
+        File layout (little endian):
+        4 bytes magic "WKDM"
+        4 bytes version
+        4 bytes page count
+        4 bytes padding
+        page count * 8 bytes timestamp, seconds since 1970 in UTC, signed
+        page count * 4 bytes page ids
+        page count * 4 bytes revision ids
+        page count * 4 bytes parent revision ids
+        page count * 4 bytes contributor ids
+        page count * 2 bytes namespaces, signed
+        page count * 20 bytes sha1 of the revision text
+        page count * 1 byte flags (WICKEDMETADATA...)
+*/
+#define WICKEDMETADATAMAGIC "WKDM"
+#define WICKEDMETADATAVERSION 1
+#define WICKEDMETADATAHEADERSIZE 16
+#define WICKEDSHA1SIZE 20
+
+// Flags of the metadata
+#define WICKEDMETADATAMINOR 1
+#define WICKEDMETADATASHA1 2
+
+//------------------------------------------------------------------------------
+// Reader
+
+typedef struct wickedColumn {
+  unsigned char type;
+  unsigned char width;
+  unsigned long long length;
+  const unsigned char *data;
+} wickedColumn;
+
+typedef struct wickedTable {
+  int fileDescriptor;
+  size_t size;
+  const unsigned char *base;
+  unsigned int kind;
+  unsigned int rowCount;
+  unsigned int columnCount;
+  struct wickedColumn columns[WICKEDMAXCOLUMNS];
+} wickedTable;
+
+typedef struct wickedCursor {
+  unsigned int row;
+  unsigned long long readerPos[WICKEDMAXCOLUMNS];
+  long long lastValue[WICKEDMAXCOLUMNS];
+} wickedCursor;
+
+/*
+  NOTE: "values" holds the integer columns, "strings" and "stringLengths" the
+        string columns of the row. Strings point into the mapped file and stay
+        valid until the table is closed.
+*/
+typedef struct wickedRow {
+  long long values[WICKEDMAXCOLUMNS];
+  const char *strings[WICKEDMAXCOLUMNS];
+  unsigned int stringLengths[WICKEDMAXCOLUMNS];
+} wickedRow;
+
+typedef struct wickedIndex {
+  int fileDescriptor;
+  size_t size;
+  const unsigned char *base;
+  unsigned int pageCount;
+  unsigned int fileCount;
+  unsigned int recordSize;
+  const unsigned char *records;
+  const unsigned char *byId;
+  const unsigned char *byTitle;
+  const char *titles;
+} wickedIndex;
+
+/*
+  NOTE: "startBytes" and "endBytes" hold the byte range of the page rows in
+        each file of the index, the title points into the mapped file.
+*/
+typedef struct wickedPage {
+  unsigned int record;
+  unsigned int pageId;
+  unsigned int startLine;
+  unsigned int endLine;
+  const char *title;
+  unsigned long long startBytes[WICKEDINDEXMAXFILES];
+  unsigned long long endBytes[WICKEDINDEXMAXFILES];
+} wickedPage;
+
+typedef struct wickedVocabulary {
+  int fileDescriptor;
+  size_t size;
+  const unsigned char *base;
+  unsigned int wordCount;
+  unsigned int blockSize;
+  unsigned int blockCount;
+  unsigned long long dataLength;
+  const unsigned char *blockOffsets;
+  const unsigned char *data;
+} wickedVocabulary;
+
+typedef struct wickedGraph {
+  int fileDescriptor;
+  size_t size;
+  const unsigned char *base;
+  unsigned int pageCount;
+  unsigned int unresolvedCount;
+  unsigned long long linkCount;
+  const unsigned char *offsets;
+  const unsigned char *pageIds;
+  const unsigned char *targets;
+  const unsigned char *byId;
+} wickedGraph;
+
+typedef struct wickedMetadata {
+  int fileDescriptor;
+  size_t size;
+  const unsigned char *base;
+  unsigned int pageCount;
+} wickedMetadata;
+
+typedef struct wickedPageMetadata {
+  unsigned int pageId;
+  unsigned int revisionId;
+  unsigned int parentId;
+  unsigned int contributorId;
+  short namespaceKey;
+  bool isMinor;
+  bool hasSha1;
+  long long timestamp;
+  unsigned char sha1[WICKEDSHA1SIZE];
+} wickedPageMetadata;
+
+typedef struct wickedPostings {
+  int fileDescriptor;
+  size_t size;
+  const unsigned char *base;
+  unsigned int termCount;
+  const unsigned char *terms;
+  const char *termHeap;
+  const unsigned char *postings;
+} wickedPostings;
+
+/*
+  NOTE: A term and the cursor over its postings, "pageId" and "position" hold
+        the last posting read by wickedNextPosting.
+*/
+typedef struct wickedTerm {
+  unsigned int termId;
+  unsigned int postingCount;
+  unsigned int pageCount;
+  const char *data;
+  const unsigned char *postings;
+  unsigned int postingsLength;
+  unsigned int postingIndex;
+  unsigned long long readerPos;
+  unsigned int pageId;
+  unsigned int position;
+} wickedTerm;
+
+bool wickedOpenTable(struct wickedTable*, const char*);
+void wickedCloseTable(struct wickedTable*);
+void wickedResetCursor(struct wickedCursor*);
+bool wickedNextRow(const struct wickedTable*, struct wickedCursor*, struct wickedRow*);
+const char* wickedString(const struct wickedTable*, const unsigned int, const unsigned int, unsigned int*);
+
+bool wickedOpenIndex(struct wickedIndex*, const char*);
+void wickedCloseIndex(struct wickedIndex*);
+const char* wickedIndexFileName(const struct wickedIndex*, const unsigned int);
+bool wickedIndexPage(const struct wickedIndex*, const unsigned int, struct wickedPage*);
+bool wickedFindPageId(const struct wickedIndex*, const unsigned int, struct wickedPage*);
+bool wickedFindTitle(const struct wickedIndex*, const char*, struct wickedPage*);
+
+bool wickedOpenVocabulary(struct wickedVocabulary*, const char*);
+void wickedCloseVocabulary(struct wickedVocabulary*);
+long long wickedFindWord(const struct wickedVocabulary*, const char*, const unsigned int);
+unsigned int wickedVocabularyWord(const struct wickedVocabulary*, const unsigned int, char*, const unsigned int);
+
+bool wickedOpenPostings(struct wickedPostings*, const char*);
+void wickedClosePostings(struct wickedPostings*);
+bool wickedTermById(const struct wickedPostings*, const unsigned int, struct wickedTerm*);
+bool wickedFindTerm(const struct wickedPostings*, const char*, struct wickedTerm*);
+bool wickedNextPosting(struct wickedTerm*);
+
+bool wickedOpenGraph(struct wickedGraph*, const char*);
+void wickedCloseGraph(struct wickedGraph*);
+unsigned int wickedGraphPageId(const struct wickedGraph*, const unsigned int);
+long long wickedGraphRecord(const struct wickedGraph*, const unsigned int);
+unsigned long long wickedPageLinks(const struct wickedGraph*, const unsigned int, unsigned long long*);
+unsigned int wickedLinkTarget(const struct wickedGraph*, const unsigned long long);
+
+bool wickedOpenMetadata(struct wickedMetadata*, const char*);
+void wickedCloseMetadata(struct wickedMetadata*);
+bool wickedMetadataRecord(const struct wickedMetadata*, const unsigned int, struct wickedPageMetadata*);
+
+#endif
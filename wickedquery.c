@@ -0,0 +1,205 @@
+//------------------------------------------------------------------------------
+// Author: Jan Riechers <jan@dwrox.net>
+//------------------------------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "wickedbinary.h"
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Prints the rows of one page from the text write out by the page index
+        "pages.wki", without scanning the files:
+
+        wickedquery [-b] [-d directory] [-k kind] (-i page id | -t title)
+        wickedquery [-d directory] -w word
+        wickedquery [-d directory] -l page id
+
+        "-k" limits the files to names starting with "kind" (words, wikitags,
+        entities, ...), by default words, wikitags and entities are printed.
+        "-b" writes the raw bytes of the rows only, without headings.
+        The files are read from "directory", the directory of the index.
+        "-w" prints the page id and position of each posting of the word
+        from the inverted index "postings.wkp".
+        "-l" prints the page ids the page links to from the link graph
+        "links.wkg".
+*/
+#define INDEXFILE "pages.wki"
+#define POSTINGSFILE "postings.wkp"
+#define GRAPHFILE "links.wkg"
+#define PATHLENGTH 4096
+
+bool printPostings(const char*, const char*);
+bool printLinks(const char*, const unsigned int);
+bool isDefaultFile(const char*);
+bool printPageRows(const char*, const unsigned long long, const unsigned long long, const bool);
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  const char *directory = ".";
+  const char *kind = NULL;
+  const char *title = NULL;
+  const char *word = NULL;
+  unsigned int pageId = 0;
+  bool isById = false;
+  bool isLinks = false;
+  bool isRaw = false;
+  int option = 0;
+
+  char path[PATHLENGTH];
+  wickedIndex index;
+  wickedPage page;
+
+  while ((option = getopt(argc, argv, "bd:k:i:l:t:w:")) != -1) {
+    switch (option) {
+      case 'b': isRaw = true; break;
+      case 'd': directory = optarg; break;
+      case 'k': kind = optarg; break;
+      case 'i': pageId = strtoul(optarg, NULL, 10); isById = true; break;
+      case 'l': pageId = strtoul(optarg, NULL, 10); isLinks = true; break;
+      case 't': title = optarg; break;
+      case 'w': word = optarg; break;
+      default:
+        fprintf(stderr, "Usage: %s [-b] [-d directory] [-k kind] (-i page id | -t title | -w word | -l page id)\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if (word != NULL) {
+    snprintf(path, PATHLENGTH, "%s/%s", directory, POSTINGSFILE);
+    return printPostings(path, word) ? 0 : 1;
+  }
+
+  if (isLinks) {
+    snprintf(path, PATHLENGTH, "%s/%s", directory, GRAPHFILE);
+    return printLinks(path, pageId) ? 0 : 1;
+  }
+
+  if (!isById && title == NULL) {
+    fprintf(stderr, "Usage: %s [-b] [-d directory] [-k kind] (-i page id | -t title | -w word | -l page id)\n", argv[0]);
+    return 1;
+  }
+
+  snprintf(path, PATHLENGTH, "%s/%s", directory, INDEXFILE);
+  if (!wickedOpenIndex(&index, path)) {
+    fprintf(stderr, "[ ERROR ] Cannot open page index \"%s\".\n", path);
+    return 1;
+  }
+
+  if (!(isById ? wickedFindPageId(&index, pageId, &page) : wickedFindTitle(&index, title, &page))) {
+    fprintf(stderr, "[ ERROR ] Page not found.\n");
+    wickedCloseIndex(&index);
+    return 1;
+  }
+
+  if (!isRaw) printf("# PAGE %u \"%s\" | LINES %u - %u\n", page.pageId, page.title, page.startLine, page.endLine);
+
+  for (unsigned int i = 0; i < index.fileCount; ++i) {
+    const char *fileName = wickedIndexFileName(&index, i);
+
+    if (kind != NULL ? strncmp(fileName, kind, strlen(kind)) != 0 : !isDefaultFile(fileName)) continue;
+
+    if (!isRaw) printf("## %s | BYTES %llu - %llu\n", fileName, page.startBytes[i], page.endBytes[i]);
+
+    snprintf(path, PATHLENGTH, "%s/%s", directory, fileName);
+    if (!printPageRows(path, page.startBytes[i], page.endBytes[i], isRaw)) {
+      fprintf(stderr, "[ ERROR ] Cannot read \"%s\".\n", path);
+    }
+  }
+
+  wickedCloseIndex(&index);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
+bool printPostings(const char *fileName, const char *word) {
+  wickedPostings index;
+  wickedTerm term;
+
+  if (!wickedOpenPostings(&index, fileName)) {
+    fprintf(stderr, "[ ERROR ] Cannot open inverted index \"%s\".\n", fileName);
+    return false;
+  }
+
+  if (!wickedFindTerm(&index, word, &term)) {
+    fprintf(stderr, "[ ERROR ] Word not found.\n");
+    wickedClosePostings(&index);
+    return false;
+  }
+
+  printf("# WORD \"%s\" | ID %u | POSTINGS %u | PAGES %u\n", term.data, term.termId, term.postingCount, term.pageCount);
+  while (wickedNextPosting(&term)) printf("%u\t%u\n", term.pageId, term.position);
+
+  wickedClosePostings(&index);
+  return true;
+}
+
+bool printLinks(const char *fileName, const unsigned int pageId) {
+  wickedGraph graph;
+  unsigned long long firstLink = 0;
+  unsigned long long linkCount = 0;
+  long long record = -1;
+
+  if (!wickedOpenGraph(&graph, fileName)) {
+    fprintf(stderr, "[ ERROR ] Cannot open link graph \"%s\".\n", fileName);
+    return false;
+  }
+
+  record = wickedGraphRecord(&graph, pageId);
+  if (record == -1) {
+    fprintf(stderr, "[ ERROR ] Page not found.\n");
+    wickedCloseGraph(&graph);
+    return false;
+  }
+
+  linkCount = wickedPageLinks(&graph, record, &firstLink);
+  printf("# PAGE %u | LINKS %llu\n", pageId, linkCount);
+  for (unsigned long long i = firstLink; i < firstLink + linkCount; ++i) printf("%u\n", wickedGraphPageId(&graph, wickedLinkTarget(&graph, i)));
+
+  wickedCloseGraph(&graph);
+  return true;
+}
+
+bool isDefaultFile(const char *fileName) {
+  return strncmp(fileName, "words", 5) == 0 || strncmp(fileName, "wikitags", 8) == 0 || strncmp(fileName, "entities", 8) == 0;
+}
+
+/*
+  NOTE: Maps the file and writes the byte range of the page. Compressed or
+        sharded files have no matching byte offsets and are refused.
+*/
+bool printPageRows(const char *fileName, const unsigned long long startByte, const unsigned long long endByte, const bool isRaw) {
+  struct stat fileInfo;
+  const char *data = NULL;
+  const char *suffix = strrchr(fileName, '.');
+  int fileDescriptor = -1;
+
+  if (suffix != NULL && (strcmp(suffix, ".gz") == 0 || strcmp(suffix, ".zst") == 0)) return false;
+  if (startByte == endByte) return true;
+
+  fileDescriptor = open(fileName, O_RDONLY);
+  if (fileDescriptor == -1) return false;
+
+  if (fstat(fileDescriptor, &fileInfo) != 0 || (unsigned long long) fileInfo.st_size < endByte) {
+    close(fileDescriptor);
+    return false;
+  }
+
+  data = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+  close(fileDescriptor);
+  if (data == MAP_FAILED) return false;
+
+  fwrite(&data[startByte], 1, endByte - startByte, stdout);
+  if (!isRaw && data[endByte - 1] != '\n') fputc('\n', stdout);
+
+  munmap((void*) data, fileInfo.st_size);
+  return true;
+}
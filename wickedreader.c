@@ -0,0 +1,660 @@
+//------------------------------------------------------------------------------
+// Author: Jan Riechers <jan@dwrox.net>
+//------------------------------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "wickedbinary.h"
+
+//------------------------------------------------------------------------------
+
+static unsigned long long readUnsigned(const unsigned char *data, const unsigned short width) {
+  unsigned long long value = 0;
+
+  for (unsigned short i = 0; i < width; ++i) value |= (unsigned long long) data[i] << (8 * i);
+
+  return value;
+}
+
+static long long readFixed(const unsigned char *data, const unsigned short width) {
+  unsigned long long value = readUnsigned(data, width);
+
+  // Sign extension of the stored width
+  if (width < 8 && (value >> (8 * width - 1)) & 1) value |= ~0ULL << (8 * width);
+
+  return (long long) value;
+}
+
+/*
+  NOTE: Reads one zigzag varint of a column of "length" bytes, returns false for
+        a varint running past the column or wider than 64 bits.
+*/
+static bool readVarint(const unsigned char *data, const unsigned long long length, unsigned long long *readerPos, long long *value) {
+  unsigned long long result = 0;
+  unsigned short shift = 0;
+
+  do {
+    if (*readerPos >= length || shift > 63) return false;
+    result |= (unsigned long long) (data[*readerPos] & 0x7F) << shift;
+    shift += 7;
+  } while (data[(*readerPos)++] & 0x80);
+
+  // NOTE: Zigzag, 0 => 0, 1 => -1, 2 => 1 ...
+  *value = (long long) (result >> 1) ^ -(long long) (result & 1);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Opens and maps the file, checks its magic and version and that it holds
+        at least "minSize" bytes. The descriptor is -1 and the map NULL on failure.
+*/
+static bool mapWickedFile(const char *fileName, const char *magic, const unsigned int version, const size_t minSize, int *fileDescriptor, const unsigned char **base, size_t *size) {
+  struct stat fileInfo;
+
+  *base = NULL;
+  *size = 0;
+  *fileDescriptor = open(fileName, O_RDONLY);
+  if (*fileDescriptor == -1) return false;
+
+  if (fstat(*fileDescriptor, &fileInfo) != 0 || fileInfo.st_size < (off_t) minSize) {
+    close(*fileDescriptor);
+    *fileDescriptor = -1;
+    return false;
+  }
+
+  *size = fileInfo.st_size;
+  *base = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, *fileDescriptor, 0);
+  if (*base == MAP_FAILED) {
+    close(*fileDescriptor);
+    *fileDescriptor = -1;
+    *base = NULL;
+    return false;
+  }
+
+  if (memcmp(*base, magic, 4) != 0 || readUnsigned(&(*base)[4], 4) != version) {
+    munmap((void*) *base, *size);
+    close(*fileDescriptor);
+    *fileDescriptor = -1;
+    *base = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Maps the file and reads the column directory, rows are not touched
+        until they are iterated.
+*/
+bool wickedOpenTable(wickedTable *table, const char *fileName) {
+  const unsigned char *columnEntry = NULL;
+
+  memset(table, 0, sizeof(wickedTable));
+  if (!mapWickedFile(fileName, WICKEDMAGIC, WICKEDVERSION, WICKEDHEADERSIZE, &table->fileDescriptor, &table->base, &table->size)) return false;
+
+  table->kind = readUnsigned(&table->base[8], 4);
+  table->rowCount = readUnsigned(&table->base[12], 4);
+  table->columnCount = readUnsigned(&table->base[16], 4);
+
+  if (table->columnCount > WICKEDMAXCOLUMNS || WICKEDHEADERSIZE + table->columnCount * WICKEDCOLUMNENTRYSIZE > table->size) {
+    wickedCloseTable(table);
+    return false;
+  }
+
+  for (unsigned int i = 0; i < table->columnCount; ++i) {
+    columnEntry = &table->base[WICKEDHEADERSIZE + i * WICKEDCOLUMNENTRYSIZE];
+    unsigned long long offset = readUnsigned(&columnEntry[8], 8);
+
+    table->columns[i].type = columnEntry[0];
+    table->columns[i].width = columnEntry[1];
+    table->columns[i].length = readUnsigned(&columnEntry[16], 8);
+
+    // NOTE: Fixed columns hold a value per row, string columns an offset per row and the end offset
+    if (offset > table->size || table->columns[i].length > table->size - offset ||
+        (table->columns[i].type == WICKEDFIXED && (table->columns[i].width == 0 || table->columns[i].width > 8 || (unsigned long long) table->rowCount * table->columns[i].width > table->columns[i].length)) ||
+        (table->columns[i].type == WICKEDSTRING && (table->rowCount + 1ULL) * 8 > table->columns[i].length) ||
+        table->columns[i].type > WICKEDSTRING) {
+      wickedCloseTable(table);
+      return false;
+    }
+
+    table->columns[i].data = &table->base[offset];
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+void wickedCloseTable(wickedTable *table) {
+  if (table->base != NULL) munmap((void*) table->base, table->size);
+  if (table->fileDescriptor >= 0) close(table->fileDescriptor);
+  table->base = NULL;
+  table->fileDescriptor = -1;
+}
+
+//------------------------------------------------------------------------------
+
+void wickedResetCursor(wickedCursor *cursor) {
+  memset(cursor, 0, sizeof(wickedCursor));
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Reads the next row into "row", returns false after the last row or for
+        a row that runs past its column.
+*/
+bool wickedNextRow(const wickedTable *table, wickedCursor *cursor, wickedRow *row) {
+  const wickedColumn *column = NULL;
+  long long value = 0;
+
+  if (cursor->row >= table->rowCount) return false;
+
+  for (unsigned int i = 0; i < table->columnCount; ++i) {
+    column = &table->columns[i];
+
+    switch (column->type) {
+      case WICKEDFIXED:
+        row->values[i] = readFixed(&column->data[cursor->row * column->width], column->width);
+        break;
+      case WICKEDVARINT:
+        if (!readVarint(column->data, column->length, &cursor->readerPos[i], &row->values[i])) return false;
+        break;
+      case WICKEDDELTA:
+        if (!readVarint(column->data, column->length, &cursor->readerPos[i], &value)) return false;
+        cursor->lastValue[i] += value;
+        row->values[i] = cursor->lastValue[i];
+        break;
+      case WICKEDSTRING:
+        row->strings[i] = wickedString(table, i, cursor->row, &row->stringLengths[i]);
+        if (row->strings[i] == NULL) return false;
+        break;
+    }
+  }
+
+  ++cursor->row;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: String columns can be read at random, returns the '\0' terminated
+        string of the row or NULL.
+*/
+const char* wickedString(const wickedTable *table, const unsigned int columnIndex, const unsigned int rowIndex, unsigned int *stringLength) {
+  const wickedColumn *column = &table->columns[columnIndex];
+  const unsigned long long heapStart = (table->rowCount + 1ULL) * 8;
+
+  if (column->type != WICKEDSTRING || rowIndex >= table->rowCount) return NULL;
+
+  unsigned long long start = readUnsigned(&column->data[rowIndex * 8ULL], 8);
+  unsigned long long end = readUnsigned(&column->data[(rowIndex + 1) * 8ULL], 8);
+
+  // NOTE: Offsets of a corrupt file may point outside of the heap or miss the '\0'
+  if (start >= end || end > column->length - heapStart || column->data[heapStart + end - 1] != '\0') return NULL;
+
+  if (stringLength != NULL) *stringLength = end - start - 1;
+  return (const char*) &column->data[heapStart + start];
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  NOTE: Maps the page index, lookups by page id or title are binary searches
+        over the sorted record numbers.
+*/
+bool wickedOpenIndex(wickedIndex *index, const char *fileName) {
+  unsigned long long titlesLength = 0;
+  unsigned long long recordsStart = 0;
+
+  memset(index, 0, sizeof(wickedIndex));
+  if (!mapWickedFile(fileName, WICKEDINDEXMAGIC, WICKEDINDEXVERSION, WICKEDINDEXHEADERSIZE, &index->fileDescriptor, &index->base, &index->size)) return false;
+
+  index->pageCount = readUnsigned(&index->base[8], 4);
+  index->fileCount = readUnsigned(&index->base[12], 4);
+  titlesLength = readUnsigned(&index->base[16], 8);
+  index->recordSize = 16 + 16 * index->fileCount;
+  recordsStart = WICKEDINDEXHEADERSIZE + (unsigned long long) index->fileCount * WICKEDINDEXNAMESIZE;
+
+  if (index->fileCount > WICKEDINDEXMAXFILES || recordsStart + (unsigned long long) index->pageCount * (index->recordSize + 8) + titlesLength > index->size) {
+    wickedCloseIndex(index);
+    return false;
+  }
+
+  index->records = &index->base[recordsStart];
+  index->byId = &index->records[(unsigned long long) index->pageCount * index->recordSize];
+  index->byTitle = &index->byId[index->pageCount * 4ULL];
+  index->titles = (const char*) &index->byTitle[index->pageCount * 4ULL];
+
+  return true;
+}
+
+void wickedCloseIndex(wickedIndex *index) {
+  if (index->base != NULL) munmap((void*) index->base, index->size);
+  if (index->fileDescriptor >= 0) close(index->fileDescriptor);
+  index->base = NULL;
+  index->fileDescriptor = -1;
+}
+
+const char* wickedIndexFileName(const wickedIndex *index, const unsigned int fileIndex) {
+  if (fileIndex >= index->fileCount) return NULL;
+  return (const char*) &index->base[WICKEDINDEXHEADERSIZE + fileIndex * WICKEDINDEXNAMESIZE];
+}
+
+bool wickedIndexPage(const wickedIndex *index, const unsigned int record, wickedPage *page) {
+  const unsigned char *data = NULL;
+
+  if (record >= index->pageCount) return false;
+
+  data = &index->records[(unsigned long long) record * index->recordSize];
+  page->record = record;
+  page->pageId = readUnsigned(data, 4);
+  page->startLine = readUnsigned(&data[4], 4);
+  page->endLine = readUnsigned(&data[8], 4);
+  page->title = &index->titles[readUnsigned(&data[12], 4)];
+
+  for (unsigned int i = 0; i < index->fileCount; ++i) {
+    page->startBytes[i] = readUnsigned(&data[16 + i * 16], 8);
+    page->endBytes[i] = readUnsigned(&data[24 + i * 16], 8);
+  }
+
+  return true;
+}
+
+/*
+  NOTE: Finds the first page of the id or title, returns false if there is none.
+*/
+bool wickedFindPageId(const wickedIndex *index, const unsigned int pageId, wickedPage *page) {
+  unsigned int low = 0;
+  unsigned int high = index->pageCount;
+
+  while (low < high) {
+    unsigned int middle = low + (high - low) / 2;
+    unsigned int record = readUnsigned(&index->byId[middle * 4ULL], 4);
+
+    if (readUnsigned(&index->records[(unsigned long long) record * index->recordSize], 4) < pageId) low = middle + 1;
+    else high = middle;
+  }
+
+  if (low == index->pageCount) return false;
+  return wickedIndexPage(index, readUnsigned(&index->byId[low * 4ULL], 4), page) && page->pageId == pageId;
+}
+
+bool wickedFindTitle(const wickedIndex *index, const char *title, wickedPage *page) {
+  unsigned int low = 0;
+  unsigned int high = index->pageCount;
+
+  while (low < high) {
+    unsigned int middle = low + (high - low) / 2;
+    unsigned int record = readUnsigned(&index->byTitle[middle * 4ULL], 4);
+    const char *pageTitle = &index->titles[readUnsigned(&index->records[(unsigned long long) record * index->recordSize + 12], 4)];
+
+    if (strcmp(pageTitle, title) < 0) low = middle + 1;
+    else high = middle;
+  }
+
+  if (low == index->pageCount) return false;
+  return wickedIndexPage(index, readUnsigned(&index->byTitle[low * 4ULL], 4), page) && strcmp(page->title, title) == 0;
+}
+
+//------------------------------------------------------------------------------
+
+static unsigned long long readLength(const unsigned char *data, unsigned long long *readerPos) {
+  unsigned long long value = 0;
+  unsigned short shift = 0;
+
+  do {
+    value |= (unsigned long long) (data[*readerPos] & 0x7F) << shift;
+    shift += 7;
+  } while (data[(*readerPos)++] & 0x80);
+
+  return value;
+}
+
+bool wickedOpenVocabulary(wickedVocabulary *vocabulary, const char *fileName) {
+  unsigned long long dataStart = 0;
+
+  memset(vocabulary, 0, sizeof(wickedVocabulary));
+  if (!mapWickedFile(fileName, WICKEDVOCABULARYMAGIC, WICKEDVOCABULARYVERSION, WICKEDVOCABULARYHEADERSIZE, &vocabulary->fileDescriptor, &vocabulary->base, &vocabulary->size)) return false;
+
+  vocabulary->wordCount = readUnsigned(&vocabulary->base[8], 4);
+  vocabulary->blockSize = readUnsigned(&vocabulary->base[12], 4);
+  vocabulary->blockCount = readUnsigned(&vocabulary->base[16], 4);
+  vocabulary->dataLength = readUnsigned(&vocabulary->base[24], 8);
+  dataStart = WICKEDVOCABULARYHEADERSIZE + vocabulary->blockCount * 8ULL;
+
+  if (vocabulary->blockSize == 0 || dataStart + vocabulary->dataLength > vocabulary->size) {
+    wickedCloseVocabulary(vocabulary);
+    return false;
+  }
+
+  vocabulary->blockOffsets = &vocabulary->base[WICKEDVOCABULARYHEADERSIZE];
+  vocabulary->data = &vocabulary->base[dataStart];
+
+  return true;
+}
+
+void wickedCloseVocabulary(wickedVocabulary *vocabulary) {
+  if (vocabulary->base != NULL) munmap((void*) vocabulary->base, vocabulary->size);
+  if (vocabulary->fileDescriptor >= 0) close(vocabulary->fileDescriptor);
+  vocabulary->base = NULL;
+  vocabulary->fileDescriptor = -1;
+}
+
+/*
+  NOTE: Compares "word" from "matched" bytes on with "length" bytes at "data",
+        sets "matched" to the bytes both share and returns the order as strcmp.
+*/
+static int compareWordPart(const char *word, const unsigned int wordLength, unsigned int *matched, const unsigned char *data, const unsigned long long length) {
+  unsigned long long readerPos = 0;
+
+  while (readerPos < length && *matched < wordLength && (unsigned char) word[*matched] == data[readerPos]) {
+    ++readerPos;
+    ++*matched;
+  }
+
+  if (readerPos == length) return *matched == wordLength ? 0 : 1;
+  if (*matched == wordLength) return -1;
+  return (unsigned char) word[*matched] < data[readerPos] ? -1 : 1;
+}
+
+/*
+  NOTE: Returns the id of the word or -1. A binary search finds the last block
+        starting ahead of the word, the block is scanned by the shared prefix
+        lengths without building its words.
+*/
+long long wickedFindWord(const wickedVocabulary *vocabulary, const char *word, const unsigned int wordLength) {
+  unsigned int low = 0;
+  unsigned int high = vocabulary->blockCount;
+  unsigned long long readerPos = 0;
+  unsigned long long length = 0;
+  unsigned int matched = 0;
+  int order = 0;
+
+  // First block with a head after the word
+  while (low < high) {
+    unsigned int middle = low + (high - low) / 2;
+
+    readerPos = readUnsigned(&vocabulary->blockOffsets[middle * 8ULL], 8);
+    length = readLength(vocabulary->data, &readerPos);
+    matched = 0;
+
+    if (compareWordPart(word, wordLength, &matched, &vocabulary->data[readerPos], length) >= 0) low = middle + 1;
+    else high = middle;
+  }
+
+  if (low == 0) return -1;
+
+  const unsigned int block = low - 1;
+  const unsigned int blockWords = block + 1 == vocabulary->blockCount ? vocabulary->wordCount - block * vocabulary->blockSize : vocabulary->blockSize;
+
+  readerPos = readUnsigned(&vocabulary->blockOffsets[block * 8ULL], 8);
+  length = readLength(vocabulary->data, &readerPos);
+  matched = 0;
+  order = compareWordPart(word, wordLength, &matched, &vocabulary->data[readerPos], length);
+  readerPos += length;
+
+  for (unsigned int i = 1; order > 0 && i < blockWords; ++i) {
+    unsigned long long prefixLength = readLength(vocabulary->data, &readerPos);
+    length = readLength(vocabulary->data, &readerPos);
+
+    // NOTE: A longer shared prefix keeps the word ahead, a shorter one puts it behind
+    if (prefixLength < matched) return -1;
+    if (prefixLength == matched) {
+      order = compareWordPart(word, wordLength, &matched, &vocabulary->data[readerPos], length);
+      if (order == 0) return (long long) block * vocabulary->blockSize + i;
+    }
+
+    readerPos += length;
+  }
+
+  return order == 0 ? (long long) block * vocabulary->blockSize : -1;
+}
+
+/*
+  NOTE: Writes the word of "id" '\0' terminated into "buffer" and returns its
+        length, 0 for an unknown id or a word longer than the buffer.
+*/
+unsigned int wickedVocabularyWord(const wickedVocabulary *vocabulary, const unsigned int id, char *buffer, const unsigned int bufferSize) {
+  unsigned long long readerPos = 0;
+  unsigned long long prefixLength = 0;
+  unsigned long long length = 0;
+
+  if (id >= vocabulary->wordCount) return 0;
+
+  readerPos = readUnsigned(&vocabulary->blockOffsets[(id / vocabulary->blockSize) * 8ULL], 8);
+  for (unsigned int i = 0; i <= id % vocabulary->blockSize; ++i) {
+    if (i != 0) prefixLength = readLength(vocabulary->data, &readerPos);
+    length = readLength(vocabulary->data, &readerPos);
+    if (prefixLength + length >= bufferSize) return 0;
+
+    memcpy(&buffer[prefixLength], &vocabulary->data[readerPos], length);
+    readerPos += length;
+  }
+
+  buffer[prefixLength + length] = '\0';
+  return prefixLength + length;
+}
+
+//------------------------------------------------------------------------------
+
+bool wickedOpenPostings(wickedPostings *index, const char *fileName) {
+  unsigned long long termsLength = 0;
+  unsigned long long postingsLength = 0;
+  unsigned long long postingsStart = 0;
+
+  memset(index, 0, sizeof(wickedPostings));
+  if (!mapWickedFile(fileName, WICKEDPOSTINGSMAGIC, WICKEDPOSTINGSVERSION, WICKEDPOSTINGSHEADERSIZE, &index->fileDescriptor, &index->base, &index->size)) return false;
+
+  index->termCount = readUnsigned(&index->base[8], 4);
+  termsLength = readUnsigned(&index->base[16], 8);
+  postingsLength = readUnsigned(&index->base[24], 8);
+  postingsStart = (WICKEDPOSTINGSHEADERSIZE + index->termCount * (unsigned long long) WICKEDTERMENTRYSIZE + termsLength + 7) & ~7ULL;
+
+  if (postingsStart + postingsLength > index->size) {
+    wickedClosePostings(index);
+    return false;
+  }
+
+  index->terms = &index->base[WICKEDPOSTINGSHEADERSIZE];
+  index->termHeap = (const char*) &index->terms[index->termCount * (unsigned long long) WICKEDTERMENTRYSIZE];
+  index->postings = &index->base[postingsStart];
+
+  return true;
+}
+
+void wickedClosePostings(wickedPostings *index) {
+  if (index->base != NULL) munmap((void*) index->base, index->size);
+  if (index->fileDescriptor >= 0) close(index->fileDescriptor);
+  index->base = NULL;
+  index->fileDescriptor = -1;
+}
+
+bool wickedTermById(const wickedPostings *index, const unsigned int termId, wickedTerm *term) {
+  const unsigned char *entry = NULL;
+
+  if (termId >= index->termCount) return false;
+
+  entry = &index->terms[termId * (unsigned long long) WICKEDTERMENTRYSIZE];
+  memset(term, 0, sizeof(wickedTerm));
+  term->termId = termId;
+  term->postings = &index->postings[readUnsigned(entry, 8)];
+  term->postingsLength = readUnsigned(&entry[8], 4);
+  term->postingCount = readUnsigned(&entry[12], 4);
+  term->pageCount = readUnsigned(&entry[16], 4);
+  term->data = &index->termHeap[readUnsigned(&entry[20], 4)];
+
+  return true;
+}
+
+/*
+  NOTE: Binary search over the sorted terms, returns false for unknown words.
+*/
+bool wickedFindTerm(const wickedPostings *index, const char *word, wickedTerm *term) {
+  unsigned int low = 0;
+  unsigned int high = index->termCount;
+
+  while (low < high) {
+    unsigned int middle = low + (high - low) / 2;
+    const char *data = &index->termHeap[readUnsigned(&index->terms[middle * (unsigned long long) WICKEDTERMENTRYSIZE + 20], 4)];
+
+    if (strcmp(data, word) < 0) low = middle + 1;
+    else high = middle;
+  }
+
+  return wickedTermById(index, low, term) && strcmp(term->data, word) == 0;
+}
+
+/*
+  NOTE: Reads the next posting of the term into "pageId" and "position",
+        returns false after the last one.
+*/
+bool wickedNextPosting(wickedTerm *term) {
+  unsigned long long pageDelta = 0;
+  unsigned long long position = 0;
+
+  if (term->readerPos >= term->postingsLength) return false;
+
+  pageDelta = readLength(term->postings, &term->readerPos);
+  position = readLength(term->postings, &term->readerPos);
+
+  if (term->postingIndex == 0 || pageDelta != 0) term->position = position;
+  else term->position += position;
+  term->pageId += pageDelta;
+
+  ++term->postingIndex;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool wickedOpenGraph(wickedGraph *graph, const char *fileName) {
+  unsigned long long graphLength = 0;
+
+  memset(graph, 0, sizeof(wickedGraph));
+  if (!mapWickedFile(fileName, WICKEDGRAPHMAGIC, WICKEDGRAPHVERSION, WICKEDGRAPHHEADERSIZE, &graph->fileDescriptor, &graph->base, &graph->size)) return false;
+
+  graph->pageCount = readUnsigned(&graph->base[8], 4);
+  graph->unresolvedCount = readUnsigned(&graph->base[12], 4);
+  graph->linkCount = readUnsigned(&graph->base[16], 8);
+  graphLength = WICKEDGRAPHHEADERSIZE + (graph->pageCount + 1ULL) * 8 + graph->pageCount * 8ULL + graph->linkCount * 4;
+
+  if (graphLength > graph->size) {
+    wickedCloseGraph(graph);
+    return false;
+  }
+
+  graph->offsets = &graph->base[WICKEDGRAPHHEADERSIZE];
+  graph->pageIds = &graph->offsets[(graph->pageCount + 1ULL) * 8];
+  graph->targets = &graph->pageIds[graph->pageCount * 4ULL];
+  graph->byId = &graph->targets[graph->linkCount * 4];
+
+  return true;
+}
+
+void wickedCloseGraph(wickedGraph *graph) {
+  if (graph->base != NULL) munmap((void*) graph->base, graph->size);
+  if (graph->fileDescriptor >= 0) close(graph->fileDescriptor);
+  graph->base = NULL;
+  graph->fileDescriptor = -1;
+}
+
+unsigned int wickedGraphPageId(const wickedGraph *graph, const unsigned int record) {
+  return readUnsigned(&graph->pageIds[record * 4ULL], 4);
+}
+
+// NOTE: Returns the record of the first page with the page id or -1
+long long wickedGraphRecord(const wickedGraph *graph, const unsigned int pageId) {
+  unsigned int low = 0;
+  unsigned int high = graph->pageCount;
+
+  while (low < high) {
+    unsigned int middle = low + (high - low) / 2;
+
+    if (wickedGraphPageId(graph, readUnsigned(&graph->byId[middle * 4ULL], 4)) < pageId) low = middle + 1;
+    else high = middle;
+  }
+
+  if (low == graph->pageCount) return -1;
+
+  unsigned int record = readUnsigned(&graph->byId[low * 4ULL], 4);
+  return wickedGraphPageId(graph, record) == pageId ? (long long) record : -1;
+}
+
+/*
+  NOTE: Returns the count of the links of the page record and sets "firstLink"
+        to the index of its first link for wickedLinkTarget.
+*/
+unsigned long long wickedPageLinks(const wickedGraph *graph, const unsigned int record, unsigned long long *firstLink) {
+  if (record >= graph->pageCount) return 0;
+
+  *firstLink = readUnsigned(&graph->offsets[record * 8ULL], 8);
+  return readUnsigned(&graph->offsets[(record + 1ULL) * 8], 8) - *firstLink;
+}
+
+unsigned int wickedLinkTarget(const wickedGraph *graph, const unsigned long long link) {
+  return readUnsigned(&graph->targets[link * 4], 4);
+}
+
+//------------------------------------------------------------------------------
+
+bool wickedOpenMetadata(wickedMetadata *metadata, const char *fileName) {
+
+  memset(metadata, 0, sizeof(wickedMetadata));
+  if (!mapWickedFile(fileName, WICKEDMETADATAMAGIC, WICKEDMETADATAVERSION, WICKEDMETADATAHEADERSIZE, &metadata->fileDescriptor, &metadata->base, &metadata->size)) return false;
+
+  metadata->pageCount = readUnsigned(&metadata->base[8], 4);
+
+  if (WICKEDMETADATAHEADERSIZE + metadata->pageCount * (27ULL + WICKEDSHA1SIZE) > metadata->size) {
+    wickedCloseMetadata(metadata);
+    return false;
+  }
+
+  return true;
+}
+
+void wickedCloseMetadata(wickedMetadata *metadata) {
+  if (metadata->base != NULL) munmap((void*) metadata->base, metadata->size);
+  if (metadata->fileDescriptor >= 0) close(metadata->fileDescriptor);
+  metadata->base = NULL;
+  metadata->fileDescriptor = -1;
+}
+
+// NOTE: Reads the metadata of the page record from its columns
+bool wickedMetadataRecord(const wickedMetadata *metadata, const unsigned int record, wickedPageMetadata *pageMetadata) {
+  const unsigned long long pageCount = metadata->pageCount;
+  const unsigned char *column = &metadata->base[WICKEDMETADATAHEADERSIZE];
+  unsigned char flags = 0;
+
+  if (record >= metadata->pageCount) return false;
+
+  pageMetadata->timestamp = readFixed(&column[record * 8ULL], 8);
+  column += pageCount * 8;
+  pageMetadata->pageId = readUnsigned(&column[record * 4ULL], 4);
+  column += pageCount * 4;
+  pageMetadata->revisionId = readUnsigned(&column[record * 4ULL], 4);
+  column += pageCount * 4;
+  pageMetadata->parentId = readUnsigned(&column[record * 4ULL], 4);
+  column += pageCount * 4;
+  pageMetadata->contributorId = readUnsigned(&column[record * 4ULL], 4);
+  column += pageCount * 4;
+  pageMetadata->namespaceKey = readFixed(&column[record * 2ULL], 2);
+  column += pageCount * 2;
+  memcpy(pageMetadata->sha1, &column[record * (unsigned long long) WICKEDSHA1SIZE], WICKEDSHA1SIZE);
+  column += pageCount * WICKEDSHA1SIZE;
+  flags = column[record];
+
+  pageMetadata->isMinor = (flags & WICKEDMETADATAMINOR) != 0;
+  pageMetadata->hasSha1 = (flags & WICKEDMETADATASHA1) != 0;
+  return true;
+}